@@ -0,0 +1,24 @@
+# Run as a script (cmake -DSRC_DIR=<dir> -DOUTPUT=<file> -P BuildId.cmake) on every build.
+# Writes a hash of the library sources to OUTPUT. The bytecode cache files are tied to it (see
+# Bytecode::getBuildId()), so any change in the sources invalidates them, and a rebuild of the
+# same sources does not.
+# OUTPUT is only rewritten if the hash changes, so that nothing is recompiled needlessly.
+
+file(GLOB_RECURSE BUILD_ID_SRCS RELATIVE "${SRC_DIR}"
+    "${SRC_DIR}/src/*.cpp" "${SRC_DIR}/include/*.hpp" "${SRC_DIR}/include/*.in")
+list(SORT BUILD_ID_SRCS)
+set(BUILD_ID_HASHES "")
+foreach(src ${BUILD_ID_SRCS})
+    file(SHA1 "${SRC_DIR}/${src}" srcHash)
+    string(APPEND BUILD_ID_HASHES "${src}:${srcHash};")
+endforeach()
+string(SHA1 SOURCE_HASH "${BUILD_ID_HASHES}")
+
+set(BUILD_ID_CONTENT "// Generated by cmake/BuildId.cmake\n\nconstexpr char const *SOURCE_HASH = \"${SOURCE_HASH}\";\n")
+set(BUILD_ID_OLD_CONTENT "")
+if(EXISTS "${OUTPUT}")
+    file(READ "${OUTPUT}" BUILD_ID_OLD_CONTENT)
+endif()
+if(NOT BUILD_ID_OLD_CONTENT STREQUAL BUILD_ID_CONTENT)
+    file(WRITE "${OUTPUT}" "${BUILD_ID_CONTENT}")
+endif()
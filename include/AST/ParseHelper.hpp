@@ -8,25 +8,35 @@ namespace fer::ast
 class ParseHelper
 {
     // requires modification at parsing stage, hence not set as const
-    const ManagedList &toks;
+    const ManagedArena &toks;
     lex::Lexeme invalid, eof;
     lex::Lexeme *curr;
+    // index of curr in toks; can be one past either end, in which case curr is eof
+    ssize_t currIdx;
 
-    lex::Lexeme *getAt(lex::Lexeme *from, int offset);
+    lex::Lexeme *getAt(ssize_t idx);
 
 public:
-    ParseHelper(const ManagedList &toks, lex::Lexeme *curr = 0);
+    ParseHelper(const ManagedArena &toks, size_t begin = 0);
 
     // never returns nullptr - returns either valid data or eof
-    inline lex::Lexeme *peek(int offset = 0) { return getAt(curr, offset); }
+    inline lex::Lexeme *peek(int offset = 0) { return getAt(currIdx + offset); }
     lex::TokType peekt(int offset = 0);
 
     // never returns nullptr - returns either valid data or eof
-    inline lex::Lexeme *next() { return curr = getAt(curr, 1); }
+    inline lex::Lexeme *next()
+    {
+        if(currIdx < (ssize_t)toks.size()) ++currIdx;
+        return curr = getAt(currIdx);
+    }
     lex::TokType nextt();
 
     // never returns nullptr - returns either valid data or eof
-    inline lex::Lexeme *prev() { return curr = getAt(curr, -1); }
+    inline lex::Lexeme *prev()
+    {
+        if(currIdx >= 0) --currIdx;
+        return curr = getAt(currIdx);
+    }
     lex::TokType prevt();
 
     inline void sett(lex::TokType type)
@@ -8,7 +8,7 @@ namespace fer::ast
 
 class Parser
 {
-    ManagedList &allocator;
+    ManagedArena &allocator;
     ParseHelper p;
     Vector<Stmt *> prependBlock;
     Vector<bool> withinfunc; // only .size()/.empty() is cared for
@@ -18,10 +18,11 @@ class Parser
 
     // this is just a transformation that generates a for loop
     bool parseForIn(Stmt *&fin);
+    StmtVar *makePairElemVar(ModuleLoc loc, StringRef name, StringRef pairName, StringRef elem);
     bool parseAwait(Stmt *&resultCallExpr);
 
 public:
-    Parser(ManagedList &allocator, ManagedList &toks);
+    Parser(ManagedArena &allocator, ManagedArena &toks);
 
     // On successful parse, returns true, and tree is allocated
     // If withBrace is true, it will attempt to find the beginning and ending brace for each
@@ -69,7 +70,7 @@ public:
 };
 
 // Can modify toks since some stuff requires it (like determining pre/post operators)
-FER_API bool parse(ManagedList &allocator, ManagedList &toks, Stmt *&s, bool exprOnly);
+FER_API bool parse(ManagedArena &allocator, ManagedArena &toks, Stmt *&s, bool exprOnly);
 FER_API void dumpTree(OStream &os, Stmt *tree);
 
 } // namespace fer::ast
\ No newline at end of file
@@ -9,7 +9,7 @@ class FER_API Pass
 {
 protected:
     size_t passid;
-    ManagedList &allocator;
+    ManagedArena &allocator;
 
     // https://stackoverflow.com/questions/51332851/alternative-id-generators-for-types
     template<typename T> static inline std::uintptr_t passID()
@@ -19,7 +19,7 @@ protected:
     }
 
 public:
-    Pass(size_t passid, ManagedList &allocator);
+    Pass(size_t passid, ManagedArena &allocator);
     virtual ~Pass();
 
     template<typename T>
@@ -19,8 +19,11 @@ class FER_API CodegenPass : public Pass
     Vector<size_t> jmplocs;
     Bytecode &bc;
 
+    // Emits the additions chained on the LHS (`a + b + c + ...`) as a single ADD_CHAIN.
+    bool visitAddChain(StmtExpr *stmt);
+
 public:
-    CodegenPass(ManagedList &allocator, Bytecode &bc);
+    CodegenPass(ManagedArena &allocator, Bytecode &bc);
     ~CodegenPass() override;
 
     bool visit(Stmt *stmt, Stmt **source) override;
@@ -1,6 +1,7 @@
 #pragma once
 
-// Implements the basic parse tree simplification - including constant folding
+// Implements the basic parse tree simplification - including constant folding, propagation of
+// constant variables, inlining of small functions, and removal of dead branches
 // After this pass, StmtDefer will not be found in the code
 
 #include "AST/Passes/Base.hpp"
@@ -21,13 +22,74 @@ public:
     void applyDefers(Vector<Stmt *> &stmts);
 };
 
+// Finds the variables whose (literal) value can be propagated to their uses. A variable qualifies
+// if its name is never used in a way which may modify it (assignment, call argument, member
+// access, ...) anywhere in the module, is not mentioned in any string (like for feral.varReplace()
+// or feral.evalCode()), and is declared only once in the function (or module) body it's used in.
+class UseDefInfo
+{
+    Set<String> unsafeNames;
+    // Declarations of each name per function body (nullptr is the module body)
+    Map<StmtBlock *, StringMap<size_t>> declCounts;
+    // Names declared in the blocks of the module body, which hide its top level variables
+    Set<String> moduleBlockNames;
+    Vector<StmtBlock *> fnBlks;
+    size_t blkDepth;
+
+    // readOnly is true if the value of stmt is only read - not modified or aliased
+    void collect(Stmt *stmt, bool readOnly);
+    void collectStrNames(StringRef str);
+
+public:
+    UseDefInfo();
+
+    void analyze(Stmt *root);
+    bool canPropagate(StmtBlock *fnBlk, StringRef name);
+    // Returns true if name may refer to a local variable in the function (or module) body, instead
+    // of a top level variable of the module.
+    bool isShadowed(StmtBlock *fnBlk, StringRef name);
+
+    // Operators which create a new value from their operands, without modifying them
+    static bool isReadOnlyOper(lex::TokType oper);
+};
+
 class FER_API SimplifyPass : public Pass
 {
+    struct FnScope
+    {
+        StmtBlock *blk;    // nullptr for the module body
+        size_t firstScope; // index in constScopes
+    };
+
     bool applyConstantFolding(Stmt *&resultStmt, StmtSimple *l, StmtSimple *r, lex::TokType oper);
+    // Removes the conditionals which can never be executed, based on their literal conditions.
+    void removeDeadBranches(StmtCond *stmt, Stmt **source);
+    // Removes the loop if its condition is always false (and it has no init).
+    void removeDeadLoop(StmtFor *stmt, Stmt **source);
+    Stmt *getConstant(StringRef name);
+    StmtSimple *copySimple(StmtSimple *stmt, ModuleLoc loc);
+
+    // Returns true if the function's body is a single (small) expression which can be inlined.
+    bool isInlinable(StmtFnDef *fn);
+    bool getInlineSize(Stmt *stmt, size_t &size);
+    // Returns the callee's body with the args substituted, or nullptr if it can't be inlined.
+    Stmt *inlineCall(StmtExpr *call);
+    Stmt *cloneInline(Stmt *stmt, StringMap<StmtSimple *> &args);
+    StmtFnDef *getInlineFn(StringRef name);
+
     DeferStack defers;
+    UseDefInfo usedefs;
+    // Variables with constant values (literals and inlinable functions), for each block scope
+    Vector<StringMap<Stmt *>> constScopes;
+    // For each function being simplified - the variables of the enclosing functions are not
+    // propagated into a function since its names are resolved when it's called.
+    Vector<FnScope> fnScopes;
+    bool analyzed;
+    // false when simplifying an inlined body, so that recursive functions are inlined only once
+    bool inlineCalls;
 
 public:
-    SimplifyPass(ManagedList &allocator);
+    SimplifyPass(ManagedArena &allocator);
     ~SimplifyPass() override;
 
     bool visit(Stmt *stmt, Stmt **source) override;
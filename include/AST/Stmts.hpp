@@ -77,7 +77,7 @@ class StmtBlock : public Stmt
 public:
     StmtBlock(ModuleLoc loc, Vector<Stmt *> &&stmts, bool istop);
     ~StmtBlock();
-    static StmtBlock *create(ManagedList &allocator, ModuleLoc loc, Vector<Stmt *> &&stmts,
+    static StmtBlock *create(ManagedArena &allocator, ModuleLoc loc, Vector<Stmt *> &&stmts,
                              bool istop);
 
     void disp(bool hasNext);
@@ -101,13 +101,13 @@ public:
     StmtSimple(ModuleLoc loc, lex::TokType tokType, int64_t val);
     StmtSimple(ModuleLoc loc, lex::TokType tokType, double val);
     ~StmtSimple();
-    static StmtSimple *create(ManagedList &allocator, ModuleLoc loc, lex::TokType tokType,
+    static StmtSimple *create(ManagedArena &allocator, ModuleLoc loc, lex::TokType tokType,
                               String &&val);
-    static StmtSimple *create(ManagedList &allocator, ModuleLoc loc, lex::TokType tokType,
+    static StmtSimple *create(ManagedArena &allocator, ModuleLoc loc, lex::TokType tokType,
                               StringRef val);
-    static StmtSimple *create(ManagedList &allocator, ModuleLoc loc, lex::TokType tokType,
+    static StmtSimple *create(ManagedArena &allocator, ModuleLoc loc, lex::TokType tokType,
                               int64_t val);
-    static StmtSimple *create(ManagedList &allocator, ModuleLoc loc, lex::TokType tokType,
+    static StmtSimple *create(ManagedArena &allocator, ModuleLoc loc, lex::TokType tokType,
                               double val);
 
     void disp(bool hasNext);
@@ -138,7 +138,7 @@ class StmtFnArgs : public Stmt
 public:
     StmtFnArgs(ModuleLoc loc, Vector<Stmt *> &&args, Vector<bool> &&unpackVector);
     ~StmtFnArgs();
-    static StmtFnArgs *create(ManagedList &allocator, ModuleLoc loc, Vector<Stmt *> &&args,
+    static StmtFnArgs *create(ManagedArena &allocator, ModuleLoc loc, Vector<Stmt *> &&args,
                               Vector<bool> &&unpackVector);
 
     void disp(bool hasNext);
@@ -164,7 +164,7 @@ public:
     StmtExpr(ModuleLoc loc, Stmt *lhs, lex::TokType oper, Stmt *rhs);
     ~StmtExpr();
 
-    static StmtExpr *create(ManagedList &allocator, ModuleLoc loc, Stmt *lhs, lex::TokType oper,
+    static StmtExpr *create(ManagedArena &allocator, ModuleLoc loc, Stmt *lhs, lex::TokType oper,
                             Stmt *rhs);
 
     void disp(bool hasNext);
@@ -189,7 +189,7 @@ public:
     StmtVar(ModuleLoc loc, StringRef name, Stmt *in, Stmt *val, bool isarg);
     ~StmtVar();
     // at least one of type or val must be present
-    static StmtVar *create(ManagedList &allocator, ModuleLoc loc, StringRef name, Stmt *in,
+    static StmtVar *create(ManagedArena &allocator, ModuleLoc loc, StringRef name, Stmt *in,
                            Stmt *val, bool isarg);
 
     void disp(bool hasNext);
@@ -216,7 +216,7 @@ public:
     StmtFnSig(ModuleLoc loc, const Vector<StmtVar *> &args, StmtSimple *kwarg, StmtSimple *vaarg,
               bool createstack);
     ~StmtFnSig();
-    static StmtFnSig *create(ManagedList &allocator, ModuleLoc loc, const Vector<StmtVar *> &args,
+    static StmtFnSig *create(ManagedArena &allocator, ModuleLoc loc, const Vector<StmtVar *> &args,
                              StmtSimple *kwarg, StmtSimple *vaarg, bool createstack);
 
     void disp(bool hasNext);
@@ -239,7 +239,7 @@ class StmtFnDef : public Stmt
 public:
     StmtFnDef(ModuleLoc loc, StmtFnSig *sig, StmtBlock *blk);
     ~StmtFnDef();
-    static StmtFnDef *create(ManagedList &allocator, ModuleLoc loc, StmtFnSig *sig, StmtBlock *blk);
+    static StmtFnDef *create(ManagedArena &allocator, ModuleLoc loc, StmtFnSig *sig, StmtBlock *blk);
 
     void disp(bool hasNext);
 
@@ -262,7 +262,7 @@ public:
     StmtVarDecl(ModuleLoc loc, const Vector<StmtVar *> &decls);
     ~StmtVarDecl();
 
-    static StmtVarDecl *create(ManagedList &allocator, ModuleLoc loc,
+    static StmtVarDecl *create(ManagedArena &allocator, ModuleLoc loc,
                                const Vector<StmtVar *> &decls);
 
     void disp(bool hasNext);
@@ -298,7 +298,7 @@ class StmtCond : public Stmt
 public:
     StmtCond(ModuleLoc loc, const Vector<Conditional> &conds);
     ~StmtCond();
-    static StmtCond *create(ManagedList &allocator, ModuleLoc loc,
+    static StmtCond *create(ManagedArena &allocator, ModuleLoc loc,
                             const Vector<Conditional> &conds);
 
     void disp(bool hasNext);
@@ -319,7 +319,7 @@ public:
     StmtFor(ModuleLoc loc, Stmt *init, Stmt *cond, Stmt *incr, StmtBlock *blk);
     ~StmtFor();
     // init, cond, incr can be nullptr
-    static StmtFor *create(ManagedList &allocator, ModuleLoc loc, Stmt *init, Stmt *cond,
+    static StmtFor *create(ManagedArena &allocator, ModuleLoc loc, Stmt *init, Stmt *cond,
                            Stmt *incr, StmtBlock *blk);
 
     void disp(bool hasNext);
@@ -338,7 +338,7 @@ class StmtRetYield : public Stmt
 public:
     StmtRetYield(ModuleLoc loc, Stmt *val, bool yield);
     ~StmtRetYield();
-    static StmtRetYield *create(ManagedList &allocator, ModuleLoc loc, Stmt *val, bool yield);
+    static StmtRetYield *create(ManagedArena &allocator, ModuleLoc loc, Stmt *val, bool yield);
 
     void disp(bool hasNext);
 
@@ -351,7 +351,7 @@ class StmtContinue : public Stmt
 {
 public:
     StmtContinue(ModuleLoc loc);
-    static StmtContinue *create(ManagedList &allocator, ModuleLoc loc);
+    static StmtContinue *create(ManagedArena &allocator, ModuleLoc loc);
 
     void disp(bool hasNext);
 };
@@ -360,7 +360,7 @@ class StmtBreak : public Stmt
 {
 public:
     StmtBreak(ModuleLoc loc);
-    static StmtBreak *create(ManagedList &allocator, ModuleLoc loc);
+    static StmtBreak *create(ManagedArena &allocator, ModuleLoc loc);
 
     void disp(bool hasNext);
 };
@@ -372,7 +372,7 @@ class StmtDefer : public Stmt
 public:
     StmtDefer(ModuleLoc loc, Stmt *val);
     ~StmtDefer();
-    static StmtDefer *create(ManagedList &allocator, ModuleLoc loc, Stmt *val);
+    static StmtDefer *create(ManagedArena &allocator, ModuleLoc loc, Stmt *val);
 
     void disp(bool hasNext);
 
@@ -39,6 +39,10 @@ using AllocDetail = size_t[static_cast<uint32_t>(AllocDetails::_LAST)];
 
 constexpr size_t MAX_ROUNDUP        = 2048;
 constexpr size_t DEFAULT_POOL_SIZE  = 8 * 1024;
+constexpr size_t DEFAULT_ARENA_SIZE = 64 * 1024;
+// Number of the most recent pools looked at for free space, so that allocating from the pools does
+// not get slower as their count grows (the older ones are almost always full).
+constexpr size_t POOL_SCAN_COUNT    = 4;
 constexpr size_t MAX_ALIGNMENT      = alignof(std::max_align_t);
 constexpr size_t ALLOC_DETAIL_BYTES = sizeof(AllocDetail);
 
@@ -48,12 +52,34 @@ constexpr size_t ALLOC_DETAIL_BYTES = sizeof(AllocDetail);
 static_assert(ALLOC_DETAIL_BYTES % MAX_ALIGNMENT == 0,
               "sizeof(AllocDetail) must be a multiple of max alignment");
 
+// Power of two size classes (same as the free chunk lists), plus one for pool allocations larger
+// than MAX_ROUNDUP and one for allocations larger than the pool size.
+constexpr size_t POW2_SIZE_CLASSES = std::countr_zero(MAX_ROUNDUP);
+constexpr size_t SIZE_CLASS_COUNT  = POW2_SIZE_CLASSES + 2;
+// Max number of distinct tags (like Var types) for which allocations can be tracked.
+// Anything beyond that is accumulated in the last slot (tag = -1).
+constexpr size_t MAX_ALLOC_TAGS = 256;
+
 struct MemPool
 {
     char *head;
     char *mem;
 };
 
+struct AllocCounter
+{
+    Atomic<size_t> allocs;
+    Atomic<size_t> frees;
+    Atomic<size_t> liveBytes;
+
+    inline size_t live() const { return allocs.load() - frees.load(); }
+};
+
+struct AllocTagCounter : public AllocCounter
+{
+    Atomic<size_t> tag;
+};
+
 // Base class for anything that uses the memory manager / allocator
 class IAllocated
 {
@@ -63,6 +89,9 @@ public:
 };
 
 template<typename T> concept IAllocatedDerived = std::is_base_of_v<IAllocated, T>;
+// Types which only hold trivially destructible data (or data which is itself in the arena) can set
+// `static constexpr bool skipArenaDtor = true;` so that ManagedArena doesn't run their destructors.
+template<typename T> concept ArenaSkipsDtor = T::skipArenaDtor;
 
 class FER_API MemoryManager
 {
@@ -78,13 +107,23 @@ class FER_API MemoryManager
     String name;
     size_t poolSize;
 
+    // The size class and tag counters are only updated if this is set (see hasStats()).
+    const bool withStats;
+    Array<AllocCounter, SIZE_CLASS_COUNT> sizeClassStats;
+    Array<AllocTagCounter, MAX_ALLOC_TAGS> tagStats;
+    Atomic<size_t> freeChunkBytes; // bytes lying in the free chunk lists
+    Map<size_t, String> tagNames;
+    JThread statsDumper;
+
     inline constexpr size_t getFreeChunkIndex(size_t sz) { return std::countr_zero(sz) - 1; }
     // works upto MAX_ROUNDUP
     size_t nextPow2(size_t sz);
     void allocPool();
+    size_t getSizeClass(size_t allocSz);
+    AllocTagCounter &getTagCounter(size_t tag);
 
 public:
-    MemoryManager(StringRef name, size_t poolSize = DEFAULT_POOL_SIZE);
+    MemoryManager(StringRef name, size_t poolSize = DEFAULT_POOL_SIZE, bool withStats = false);
     ~MemoryManager();
 
     void *allocRaw(size_t size, size_t align);
@@ -93,6 +132,40 @@ public:
     // Helper function - only use if seeing memory issues.
     void dumpMem(char *pool);
 
+    // Whether the size class and tag counters are collected. It's fixed at construction so that
+    // every recorded free has a recorded allocation.
+    inline bool hasStats() const { return withStats; }
+    // Record an allocation / deallocation of `bytes` (as given by getAllocSize()) for `tag`.
+    // Must only be called if hasStats() is true.
+    void tagAlloc(size_t tag, size_t bytes);
+    void tagFree(size_t tag, size_t bytes);
+    // Name used for `tag` when dumping the statistics.
+    void setTagName(size_t tag, StringRef tagName);
+
+    // Log the allocation statistics at INFO level (shown with --verbose).
+    void dumpStats();
+    // Periodically dump the statistics every `intervalMs` milliseconds (0 = stop dumping).
+    void setStatsDumpInterval(size_t intervalMs);
+
+    // Returns the (rounded up) size of the allocation, including ALLOC_DETAIL_BYTES.
+    inline size_t getAllocSize(void *data)
+    {
+        return getAllocDetail((size_t)data, AllocDetails::SIZE);
+    }
+    // Bytes of the pools which have been handed out at least once.
+    size_t getPoolUsedBytes();
+    // Upper limit (in bytes) of the allocations in a size class - 0 for the large allocations.
+    size_t getSizeClassLimit(size_t sizeClass);
+
+    inline const Array<AllocCounter, SIZE_CLASS_COUNT> &getSizeClassStats() { return sizeClassStats; }
+    inline const Array<AllocTagCounter, MAX_ALLOC_TAGS> &getTagStats() { return tagStats; }
+    inline size_t getFreeChunkBytes() { return freeChunkBytes; }
+
+    static size_t getTotalAllocRequests();
+    static size_t getTotalAllocBytes();
+    static size_t getTotalPoolAlloc();
+    static size_t getChunkReuseCount();
+
     template<IAllocatedDerived T, typename... Args> T *allocInit(Args &&...args)
     {
         void *m = allocRaw(sizeof(T), alignof(T));
@@ -256,4 +329,70 @@ public:
     inline bool empty() const { return isEmpty(start); }
 };
 
-} // namespace fer
\ No newline at end of file
+// Cannot be a static object - as it uses the static variable `logger` in destructor.
+// Monotonic (bump) allocator - objects are carved out of a few large blocks (taken from the memory
+// manager) and are only released all together, by clear() or when the arena goes out of scope.
+// Only allocates IAllocated derived objects, which are also retained in allocation order so that
+// they can be indexed / iterated (for example, the tokens generated by the lexer).
+class FER_API ManagedArena : public IAllocated
+{
+    MemoryManager &mem;
+    String name;
+    Vector<char *> blocks;
+    Vector<IAllocated *> allocs;
+    // The allocations whose destructors must be run by clear() (see ArenaSkipsDtor).
+    Vector<IAllocated *> dtors;
+    char *head, *tail;
+    size_t blockSize;
+
+    void allocBlock(size_t minSize);
+
+public:
+    ManagedArena(MemoryManager &mem, String &&name, size_t blockSize = DEFAULT_ARENA_SIZE);
+    ManagedArena(MemoryManager &mem, const char *name, size_t blockSize = DEFAULT_ARENA_SIZE);
+    ~ManagedArena();
+
+    inline void *allocRaw(size_t size, size_t align)
+    {
+        char *loc = (char *)(((size_t)head + align - 1) & ~(align - 1));
+        if(!head || loc + size > tail) {
+            allocBlock(size + align);
+            loc = (char *)(((size_t)head + align - 1) & ~(align - 1));
+        }
+        head = loc + size;
+        return loc;
+    }
+
+    template<IAllocatedDerived T, typename... Args> T *alloc(Args &&...args)
+    {
+        T *res = new(allocRaw(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+        allocs.push_back(res);
+        if constexpr(!ArenaSkipsDtor<T>) dtors.push_back(res);
+        return res;
+    }
+    // Copies str in the arena. It lives till the arena is cleared.
+    inline StringRef allocStr(StringRef str)
+    {
+        if(str.empty()) return {};
+        char *res = (char *)allocRaw(str.size(), 1);
+        memcpy(res, str.data(), str.size());
+        return StringRef(res, str.size());
+    }
+
+    // Destroys the objects (see ArenaSkipsDtor) and gives the blocks back to the memory manager.
+    size_t clear();
+
+    inline IAllocated *at(size_t index) const
+    {
+        return index < allocs.size() ? allocs[index] : nullptr;
+    }
+    inline IAllocated *getStart() const { return allocs.empty() ? nullptr : allocs.front(); }
+    inline IAllocated *getEnd() const { return allocs.empty() ? nullptr : allocs.back(); }
+
+    inline StringRef getName() { return name; }
+    inline size_t getBlockCount() const { return blocks.size(); }
+    inline size_t size() const { return allocs.size(); }
+    inline bool empty() const { return allocs.empty(); }
+};
+
+} // namespace fer
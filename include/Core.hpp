@@ -15,6 +15,7 @@
 #include <future>
 #include <initializer_list>
 #include <iostream>
+#include <memory>
 #include <mutex>
 #include <regex>
 #include <span>
@@ -130,6 +131,7 @@ template<typename T> using Span            = std::span<T>;
 template<typename T> using Deque           = std::deque<T>;
 template<typename T> using Atomic          = std::atomic<T>;
 template<typename T> using Vector          = std::vector<T>;
+template<typename T> using SharedPtr       = std::shared_ptr<T>;
 template<typename T> using UniList         = std::forward_list<T>; // singly linked list
 template<typename T> using InitList        = std::initializer_list<T>;
 template<typename T> using LockGuard       = std::lock_guard<T>;
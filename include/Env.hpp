@@ -8,6 +8,7 @@ namespace fer::env
 String FER_API get(const char *key);
 Path FER_API getHome();
 Path FER_API getProcPath();
+int FER_API getPid();
 
 bool FER_API set(const char *key, const char *val, bool overwrite);
 
@@ -25,6 +25,8 @@ class FER_API File : public IAllocated
 
 public:
     File(const char *path, bool isVirt);
+    // Non virtual file whose contents are already available (like the sources in a bundle).
+    File(const char *path, StringRef data);
 
     Status<bool> read();
 
@@ -47,4 +49,31 @@ public:
     inline size_t sizeAppendLocs() const { return appendLocs.size(); }
 };
 
+// Read only memory mapping of an entire file.
+class FER_API MappedFile
+{
+    char *data;
+    size_t len;
+#if defined(FER_OS_WINDOWS)
+    void *fileHandle;
+    void *mapHandle;
+#endif
+
+public:
+    MappedFile();
+    MappedFile(MappedFile &&other);
+    MappedFile(const MappedFile &other) = delete;
+    ~MappedFile();
+
+    MappedFile &operator=(MappedFile &&other);
+    MappedFile &operator=(const MappedFile &other) = delete;
+
+    // Fails for empty files as well.
+    bool map(const char *path);
+    void unmap();
+
+    inline StringRef getData() const { return StringRef(data, len); }
+    inline bool isMapped() const { return data != nullptr; }
+};
+
 } // namespace fer
\ No newline at end of file
@@ -179,7 +179,10 @@ public:
 class FER_API Lexeme : public IAllocated
 {
 public:
-    using Data = Variant<String, StringRef, int64_t, double>;
+    // Strings are either in the source or in the token arena, so the lexemes own nothing.
+    using Data = Variant<StringRef, int64_t, double>;
+
+    static constexpr bool skipArenaDtor = true;
 
 private:
     Data data;
@@ -189,7 +192,6 @@ private:
 public:
     Lexeme(ModuleLoc loc = {});
     explicit Lexeme(ModuleLoc loc, TokType type);
-    explicit Lexeme(ModuleLoc loc, TokType type, String &&_data);
     explicit Lexeme(ModuleLoc loc, TokType type, StringRef _data);
     explicit Lexeme(ModuleLoc loc, int64_t _data);
     explicit Lexeme(ModuleLoc loc, double _data);
@@ -202,21 +204,11 @@ public:
     { return tok == other.tok && cmpData(other, tok.getVal()); }
     inline bool operator!=(const Lexeme &other) const { return *this == other ? false : true; }
 
-    inline void setDataStr(String &&str) { data = std::move(str); }
     inline void setDataStr(StringRef str) { data = str; }
     inline void setDataInt(int64_t i) { data = i; }
     inline void setDataFlt(double f) { data = f; }
-    template<typename... Args> void setDataStr(Args... args)
-    { data = utils::toString(std::forward<Args>(args)...); }
 
-    inline void appendDataStr(StringRef str)
-    {
-        if(!hasString()) data = String(getDataStr());
-        std::get<String>(data) += str;
-    }
-
-    inline StringRef getDataStr() const
-    { return hasString() ? std::get<String>(data) : std::get<StringRef>(data); }
+    inline StringRef getDataStr() const { return std::get<StringRef>(data); }
     inline int64_t getDataInt() const { return std::get<int64_t>(data); }
     inline double getDataFlt() const { return std::get<double>(data); }
 
@@ -224,11 +216,9 @@ public:
     inline const Tok &getTok() const { return tok; }
     inline TokType getTokVal() const { return tok.getVal(); }
     inline ModuleLoc getLoc() const { return loc; }
-
-    inline bool hasString() const { return std::holds_alternative<String>(data); }
 };
 
-FER_API bool tokenize(ModuleId moduleId, StringRef path, StringRef data, ManagedList &toks);
-FER_API void dumpTokens(OStream &os, const ManagedList &toks);
+FER_API bool tokenize(ModuleId moduleId, StringRef path, StringRef data, ManagedArena &toks);
+FER_API void dumpTokens(OStream &os, const ManagedArena &toks);
 
 } // namespace fer::lex
\ No newline at end of file
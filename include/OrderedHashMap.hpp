@@ -0,0 +1,218 @@
+#pragma once
+
+#include <bit>
+
+#include "Core.hpp"
+
+namespace fer
+{
+
+// Compact hash map, which keeps its entries in the insertion order (like the dict of CPython).
+// The entries (with their cached key hashes) are stored densely in a vector, so iterating is a
+// linear scan. They are found through a separate open addressing table of indices into the
+// entries vector, which is only built once there are more than SMALL_SIZE entries - smaller maps
+// (like most of the function frames and struct attributes) just scan the entries.
+// Erasing an entry only marks it as erased (so the positions of the other entries, and the
+// iterators, remain valid). The erased entries are dropped when the table is rebuilt while
+// inserting, unless the positions are pinned (see pinPositions()).
+// The hashing and comparison of the keys is up to the user (see OrderedStringMap below), so that
+// they can fail (like when they call a Feral function).
+template<typename K, typename V> class OrderedHashMap
+{
+public:
+    struct Entry
+    {
+        K first;
+        V second;
+        size_t hash;
+        bool erased;
+    };
+
+private:
+    static constexpr size_t SMALL_SIZE = 8;
+    static constexpr uint32_t EMPTY    = UINT32_MAX;
+    static constexpr uint32_t DUMMY    = UINT32_MAX - 1; // slot of an erased entry
+
+    Vector<Entry> entries;
+    Vector<uint32_t> index; // size is a power of 2 (or 0 when the entries are scanned)
+    size_t count;           // number of entries which are not erased
+    size_t used;            // number of slots in index which are not EMPTY
+    size_t pins;            // the erased entries are kept while this is not zero
+
+    // Returns the slot in index for the entry at pos.
+    size_t findSlot(size_t hash, size_t pos) const
+    {
+        size_t mask = index.size() - 1;
+        size_t i    = hash & mask;
+        while(index[i] != pos) i = (i + 1) & mask;
+        return i;
+    }
+    // Drops the erased entries (if the positions are not pinned), and rebuilds index for at least
+    // `cap` entries.
+    void rebuild(size_t cap)
+    {
+        if(pins == 0 && count != entries.size()) {
+            std::erase_if(entries, [](const Entry &e) { return e.erased; });
+        }
+        used = 0;
+        index.clear();
+        if(cap <= SMALL_SIZE) return;
+        // keep the load factor under 2/3
+        size_t slots = std::bit_ceil(cap + cap / 2 + 1);
+        index.assign(slots, EMPTY);
+        size_t mask = slots - 1;
+        for(size_t pos = 0; pos < entries.size(); ++pos) {
+            if(entries[pos].erased) continue;
+            size_t i = entries[pos].hash & mask;
+            while(index[i] != EMPTY) i = (i + 1) & mask;
+            index[i] = pos;
+        }
+        used = count;
+    }
+
+public:
+    class Iterator
+    {
+        Entry *curr, *last;
+
+        inline void skipErased()
+        {
+            while(curr != last && curr->erased) ++curr;
+        }
+
+    public:
+        Iterator(Entry *curr, Entry *last) : curr(curr), last(last) { skipErased(); }
+
+        inline Entry &operator*() const { return *curr; }
+        inline Entry *operator->() const { return curr; }
+        inline Iterator &operator++()
+        {
+            ++curr;
+            skipErased();
+            return *this;
+        }
+        inline bool operator==(const Iterator &other) const { return curr == other.curr; }
+        inline bool operator!=(const Iterator &other) const { return curr != other.curr; }
+    };
+
+    OrderedHashMap() : count(0), used(0), pins(0) {}
+
+    inline Iterator begin() { return Iterator(entries.data(), entries.data() + entries.size()); }
+    inline Iterator end()
+    {
+        Entry *last = entries.data() + entries.size();
+        return Iterator(last, last);
+    }
+
+    inline size_t size() const { return count; }
+    inline bool empty() const { return count == 0; }
+
+    // Positions (in insertion order) of the entries, including the erased ones - for iterating
+    // without holding a pointer to the entries, which would be invalidated by an insertion.
+    inline size_t getEndPos() const { return entries.size(); }
+    inline Entry &getAt(size_t pos) { return entries[pos]; }
+    inline size_t getPos(const Entry *e) const { return e - entries.data(); }
+    // Returns the position of the first entry (which is not erased) from pos onwards.
+    inline size_t skipErased(size_t pos) const
+    {
+        while(pos < entries.size() && entries[pos].erased) ++pos;
+        return pos;
+    }
+    // While pinned, inserting does not drop the erased entries, so the positions held by the
+    // iterators stay valid. Every pinPositions() must be paired with an unpinPositions().
+    inline void pinPositions() { ++pins; }
+    inline void unpinPositions() { --pins; }
+
+    // Returns the entry with `hash` for which eq(key) returns true, or nullptr if there's none.
+    template<typename Eq> Entry *find(size_t hash, Eq &&eq)
+    {
+        if(index.empty()) {
+            for(auto &e : entries) {
+                if(e.hash == hash && !e.erased && eq(e.first)) return &e;
+            }
+            return nullptr;
+        }
+        size_t mask = index.size() - 1;
+        for(size_t i = hash & mask; index[i] != EMPTY; i = (i + 1) & mask) {
+            if(index[i] == DUMMY) continue;
+            Entry &e = entries[index[i]];
+            if(e.hash == hash && eq(e.first)) return &e;
+        }
+        return nullptr;
+    }
+
+    // Inserts the key (which must not exist in the map) with the value, and returns its entry.
+    Entry &insert(K &&key, V val, size_t hash)
+    {
+        // the erased entries are dropped only when the entries or the table must grow anyway
+        bool full = pins == 0 && entries.size() == entries.capacity() && count != entries.size();
+        bool mustGrow = index.empty() ? entries.size() >= SMALL_SIZE
+                                      : (used + 1) * 3 > index.size() * 2;
+        if(full || mustGrow) rebuild(std::max(count + 1, count * 2));
+        entries.push_back({std::move(key), val, hash, false});
+        ++count;
+        if(!index.empty()) {
+            size_t mask = index.size() - 1;
+            size_t i    = hash & mask;
+            while(index[i] != EMPTY && index[i] != DUMMY) i = (i + 1) & mask;
+            if(index[i] == EMPTY) ++used;
+            index[i] = entries.size() - 1;
+        }
+        return entries.back();
+    }
+    // Marks the entry (returned by find()) as erased.
+    void erase(Entry *e)
+    {
+        size_t pos = e - entries.data();
+        if(!index.empty()) index[findSlot(e->hash, pos)] = DUMMY;
+        e->erased = true;
+        // frees the key's memory, unlike a (move) assignment
+        K tmp{};
+        std::swap(e->first, tmp);
+        --count;
+    }
+
+    void reserve(size_t cap)
+    {
+        if(cap <= entries.capacity()) return;
+        entries.reserve(cap);
+        if(cap > SMALL_SIZE) rebuild(cap);
+    }
+    void clear()
+    {
+        entries.clear();
+        index.clear();
+        count = 0;
+        used  = 0;
+    }
+};
+
+template<typename V> class OrderedStringMap : public OrderedHashMap<String, V>
+{
+    using Base = OrderedHashMap<String, V>;
+
+    static inline size_t hashOf(StringRef key) { return StringHash{}(key); }
+
+public:
+    using Entry = typename Base::Entry;
+
+    inline Entry *find(StringRef key)
+    {
+        return Base::find(hashOf(key), [key](const String &k) { return k == key; });
+    }
+    inline bool contains(StringRef key) { return find(key) != nullptr; }
+    inline Entry &insert(StringRef key, V val)
+    {
+        return Base::insert(String(key), val, hashOf(key));
+    }
+    using Base::erase;
+    bool erase(StringRef key)
+    {
+        Entry *e = find(key);
+        if(!e) return false;
+        Base::erase(e);
+        return true;
+    }
+};
+
+} // namespace fer
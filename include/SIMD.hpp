@@ -0,0 +1,181 @@
+#pragma once
+
+// Minimal wrappers over the SSE2/AVX2 byte operations, used for scanning long runs of text
+// multiple bytes at a time. WIDTH is 0 if neither is available, in which case only the scalar
+// fallbacks of the users must be used.
+// These began as the lexer's scanning helpers. They are shared with the text parsers of the std
+// library (JSON, FECL) and the string functions, which scan for the same kinds of runs.
+
+#include <bit>
+
+#include "Core.hpp"
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+namespace fer::simd
+{
+
+#if defined(__AVX2__)
+constexpr size_t WIDTH = 32;
+using Vec              = __m256i;
+using Mask             = uint32_t;
+inline Vec load(const char *p) { return _mm256_loadu_si256((const __m256i *)p); }
+inline Vec set1(char c) { return _mm256_set1_epi8(c); }
+inline Vec eq(Vec a, Vec b) { return _mm256_cmpeq_epi8(a, b); }
+inline Vec gt(Vec a, Vec b) { return _mm256_cmpgt_epi8(a, b); }
+inline Vec bor(Vec a, Vec b) { return _mm256_or_si256(a, b); }
+inline Vec band(Vec a, Vec b) { return _mm256_and_si256(a, b); }
+inline Vec bxor(Vec a, Vec b) { return _mm256_xor_si256(a, b); }
+inline Mask mask(Vec v) { return _mm256_movemask_epi8(v); }
+inline void store(char *p, Vec v) { _mm256_storeu_si256((__m256i *)p, v); }
+constexpr Mask ALL     = 0xFFFFFFFF;
+#elif defined(__SSE2__)
+constexpr size_t WIDTH = 16;
+using Vec              = __m128i;
+using Mask             = uint32_t;
+inline Vec load(const char *p) { return _mm_loadu_si128((const __m128i *)p); }
+inline Vec set1(char c) { return _mm_set1_epi8(c); }
+inline Vec eq(Vec a, Vec b) { return _mm_cmpeq_epi8(a, b); }
+inline Vec gt(Vec a, Vec b) { return _mm_cmpgt_epi8(a, b); }
+inline Vec bor(Vec a, Vec b) { return _mm_or_si128(a, b); }
+inline Vec band(Vec a, Vec b) { return _mm_and_si128(a, b); }
+inline Vec bxor(Vec a, Vec b) { return _mm_xor_si128(a, b); }
+inline Mask mask(Vec v) { return _mm_movemask_epi8(v); }
+inline void store(char *p, Vec v) { _mm_storeu_si128((__m128i *)p, v); }
+constexpr Mask ALL     = 0xFFFF;
+#else
+constexpr size_t WIDTH = 0;
+#endif
+
+#if defined(__AVX2__) || defined(__SSE2__)
+// (lo <= c && c <= hi) for each byte (signed comparison, so lo and hi must be < 0x80)
+inline Vec inRange(Vec c, char lo, char hi)
+{
+    return band(gt(c, set1(lo - 1)), gt(set1(hi + 1), c));
+}
+inline Vec isSpaceChar(Vec c) { return bor(eq(c, set1(' ')), inRange(c, '\t', '\r')); }
+#endif
+
+// Returns the index of the first occurrence of any of `a`, `b`, `c` from `i` onwards (or
+// data.size() if none exist).
+inline size_t findAny(StringRef data, size_t i, char a, char b, char c)
+{
+    size_t len = data.size();
+#if defined(__AVX2__) || defined(__SSE2__)
+    Vec va = set1(a), vb = set1(b), vc = set1(c);
+    for(; i + WIDTH <= len; i += WIDTH) {
+        Vec v  = load(&data[i]);
+        Mask m = mask(bor(bor(eq(v, va), eq(v, vb)), eq(v, vc)));
+        if(m) return i + std::countr_zero(m);
+    }
+#endif
+    while(i < len && data[i] != a && data[i] != b && data[i] != c) ++i;
+    return i;
+}
+
+// Returns the index of the first non whitespace character from `i` onwards.
+inline size_t skipSpaces(StringRef data, size_t i)
+{
+    size_t len = data.size();
+#if defined(__AVX2__) || defined(__SSE2__)
+    for(; i + WIDTH <= len; i += WIDTH) {
+        Mask nonSpace = ~mask(isSpaceChar(load(&data[i]))) & ALL;
+        if(nonSpace) return i + std::countr_zero(nonSpace);
+    }
+#endif
+    while(i < len && isspace(data[i])) ++i;
+    return i;
+}
+
+// Returns the index of the first non whitespace character before `end` + 1 (or 0 if all the
+// characters before `end` are whitespace).
+inline size_t skipSpacesBack(StringRef data, size_t end)
+{
+#if defined(__AVX2__) || defined(__SSE2__)
+    for(; end >= WIDTH; end -= WIDTH) {
+        Mask nonSpace = ~mask(isSpaceChar(load(&data[end - WIDTH]))) & ALL;
+        if(nonSpace) return end - WIDTH + std::bit_width(nonSpace);
+    }
+#endif
+    while(end > 0 && isspace((unsigned char)data[end - 1])) --end;
+    return end;
+}
+
+// Same as data.find(what, i).
+// Candidates are the positions where both the first and the last byte of `what` match, which are
+// then compared fully. Much faster than checking only the first byte (memchr() style) when it is
+// a common one.
+inline size_t find(StringRef data, StringRef what, size_t i = 0)
+{
+    size_t len = data.size();
+    size_t n   = what.size();
+    if(n == 0 || n > len || i > len - n) return data.find(what, i);
+#if defined(__AVX2__) || defined(__SSE2__)
+    Vec first = set1(what[0]), last = set1(what[n - 1]);
+    for(; i + n - 1 + WIDTH <= len; i += WIDTH) {
+        Mask m = mask(band(eq(load(&data[i]), first), eq(load(&data[i + n - 1]), last)));
+        for(; m; m &= m - 1) {
+            size_t pos = i + std::countr_zero(m);
+            if(n <= 2 || memcmp(&data[pos + 1], &what[1], n - 2) == 0) return pos;
+        }
+    }
+#endif
+    return data.find(what, i);
+}
+
+// Same as data.rfind(what, i), scanning backwards in the same way as find().
+inline size_t rfind(StringRef data, StringRef what, size_t i = StringRef::npos)
+{
+    size_t len = data.size();
+    size_t n   = what.size();
+    if(n == 0 || n > len) return data.rfind(what, i);
+    // positions before `end` are the remaining candidates
+    size_t end = std::min(i, len - n) + 1;
+#if defined(__AVX2__) || defined(__SSE2__)
+    Vec first = set1(what[0]), last = set1(what[n - 1]);
+    for(; end >= WIDTH; end -= WIDTH) {
+        size_t j = end - WIDTH;
+        Mask m   = mask(band(eq(load(&data[j]), first), eq(load(&data[j + n - 1]), last)));
+        while(m) {
+            size_t bit = std::bit_width(m) - 1;
+            size_t pos = j + bit;
+            if(n <= 2 || memcmp(&data[pos + 1], &what[1], n - 2) == 0) return pos;
+            m &= ~((Mask)1 << bit);
+        }
+    }
+#endif
+    if(end == 0) return StringRef::npos;
+    return data.rfind(what, end - 1);
+}
+
+// ASCII case conversion of `len` bytes at `data`, in place.
+inline void toLower(char *data, size_t len)
+{
+    size_t i = 0;
+#if defined(__AVX2__) || defined(__SSE2__)
+    for(; i + WIDTH <= len; i += WIDTH) {
+        Vec v = load(&data[i]);
+        store(&data[i], bor(v, band(inRange(v, 'A', 'Z'), set1(0x20))));
+    }
+#endif
+    for(; i < len; ++i) {
+        if(data[i] >= 'A' && data[i] <= 'Z') data[i] |= 0x20;
+    }
+}
+inline void toUpper(char *data, size_t len)
+{
+    size_t i = 0;
+#if defined(__AVX2__) || defined(__SSE2__)
+    for(; i + WIDTH <= len; i += WIDTH) {
+        Vec v = load(&data[i]);
+        store(&data[i], bxor(v, band(inRange(v, 'a', 'z'), set1(0x20))));
+    }
+#endif
+    for(; i < len; ++i) {
+        if(data[i] >= 'a' && data[i] <= 'z') data[i] ^= 0x20;
+    }
+}
+
+} // namespace fer::simd
@@ -32,8 +32,16 @@ FER_API size_t countDigits(size_t num);
 // Counts all instances of `c` in `str`.
 FER_API size_t stringCharCount(StringRef str, char ch);
 
+// Fast (non cryptographic) 64 bit hash of `data`, processed 8 bytes at a time.
+// Stable across runs and builds (unlike std::hash), so it can be stored in files.
+// `seed` can be a previous result to hash multiple pieces of data together.
+FER_API uint64_t hash64(StringRef data, uint64_t seed = 0xcbf29ce484222325);
+
 // Replaces all instances of `from` with `to` in `str`.
 FER_API void stringReplace(String &str, StringRef from, StringRef to);
+// Returns `str` with all instances of `from` replaced with `to`.
+// The instances are found in one pass, and the result is then built with its size known.
+FER_API String stringReplaceCopy(StringRef str, StringRef from, StringRef to);
 
 // Also trims the spaces for each split
 FER_API Vector<StringRef> stringDelim(StringRef str, StringRef delim);
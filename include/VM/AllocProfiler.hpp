@@ -0,0 +1,49 @@
+#pragma once
+
+#include "VarTypes.hpp"
+
+namespace fer
+{
+
+constexpr size_t DEFAULT_ALLOC_SAMPLE_BYTES = 64 * 1024;
+
+// Sampling allocation profiler.
+// Roughly every `sampleBytes` bytes of Var allocations, the Feral call stack (ModuleLoc of each
+// active call, and the location of the allocation itself) is recorded along with the allocated
+// type. The samples are aggregated per stack and can be written in folded stack format
+// (`frame;frame;...;Type <bytes>`), which is understood by flamegraph.pl, speedscope, etc.
+class FER_API AllocProfiler : public IAllocated
+{
+    struct Site
+    {
+        size_t samples;
+        size_t bytes;
+    };
+
+    Mutex mtx;
+    // Key is the raw sequence of ModuleLoc's (outermost first) followed by the type id.
+    Map<String, Site> sites;
+    Atomic<ssize_t> untilSample;
+    size_t sampleBytes;
+
+public:
+    AllocProfiler(size_t sampleBytes = DEFAULT_ALLOC_SAMPLE_BYTES);
+    ~AllocProfiler();
+
+    // Called for each Var allocation of `bytes` bytes.
+    inline void onAlloc(VirtualMachine &vm, ModuleLoc loc, size_t typeId, size_t bytes)
+    {
+        if(untilSample.fetch_sub(bytes, std::memory_order_relaxed) > (ssize_t)bytes) return;
+        untilSample.fetch_add(sampleBytes, std::memory_order_relaxed);
+        record(vm, loc, typeId);
+    }
+    void record(VirtualMachine &vm, ModuleLoc loc, size_t typeId);
+
+    // Writes the aggregated samples in folded stack format.
+    void dump(VirtualMachine &vm, OStream &os);
+    bool dump(VirtualMachine &vm, const char *path);
+
+    inline size_t getSampleBytes() { return sampleBytes; }
+};
+
+} // namespace fer
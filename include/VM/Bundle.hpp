@@ -0,0 +1,97 @@
+#pragma once
+
+#include "Bytecode.hpp"
+
+namespace fer
+{
+
+// Version of the bundle file format - must be incremented whenever the format changes.
+constexpr uint32_t BUNDLE_FORMAT_VERSION = 1;
+
+// A single file archive of a program: the sources and bytecode of the main module, the prelude and
+// everything they import, along with the resolved import() and loadlib() calls of each module.
+// When running from a bundle, the modules are loaded (and imports resolved) using it instead of
+// searching the module dirs. Native modules are not stored, only their paths and content hashes
+// (which are verified before loading them).
+// Since bytecode is specific to a feral build, a bundle can only be run by the build which created
+// it.
+class FER_API Bundle : public IAllocated
+{
+public:
+    struct Module
+    {
+        StringRef path;
+        StringRef source;
+        StringRef bytecode;
+    };
+    struct Dll
+    {
+        uint64_t size;
+        int64_t mtime;
+        uint64_t hash; // of the contents
+    };
+
+private:
+    MappedFile mapping;
+    StringMap<Module> modules;
+    // Native module path -> its info when the bundle was created
+    StringMap<Dll> dlls;
+    // getLinkKey() -> resolved path
+    StringMap<StringRef> links;
+    // Native modules which have been verified (hash) already
+    Set<String> verifiedDlls;
+    StringRef preludePath;
+    StringRef mainPath;
+
+public:
+    Bundle();
+
+    // Maps the bundle file and validates it.
+    Status<bool> open(const char *path);
+
+    const Module *getModule(StringRef path) const;
+    // Sets `result` to the path of module `name` which was resolved when it was imported (or
+    // loaded using loadlib() if `isImport` is false) by the module at `srcPath`.
+    bool resolve(StringRef srcPath, StringRef name, bool isImport, String &result) const;
+    // Returns false if the native module at `path` is not the one which was bundled.
+    bool verifyDll(StringRef path);
+
+    inline StringRef getPreludePath() const { return preludePath; }
+    inline StringRef getMainPath() const { return mainPath; }
+
+    static String getLinkKey(StringRef srcPath, StringRef name, bool isImport);
+    // Files with this extension are run as bundles.
+    static inline StringRef getExtension() { return ".fbundle"; }
+};
+
+// Creates bundle files. The first module added is the prelude.
+class FER_API BundleWriter
+{
+    struct Module
+    {
+        String path;
+        String source;
+        String bytecode;
+    };
+    struct Link
+    {
+        String srcPath;
+        String name;
+        String target;
+        bool isImport;
+    };
+
+    Vector<Module> modules;
+    StringMap<Bundle::Dll> dlls;
+    Vector<Link> links;
+
+public:
+    void addModule(StringRef path, StringRef source, const Bytecode &bc);
+    // Stores the path, the file times and the hash of the contents of the native module.
+    Status<bool> addDll(StringRef path);
+    void addLink(StringRef srcPath, StringRef name, bool isImport, StringRef target);
+
+    Status<bool> write(const char *path, StringRef mainPath) const;
+};
+
+} // namespace fer
@@ -50,6 +50,12 @@ enum class Opcode : uint8_t
     CALL,     // operand = string of arginfo
     MEM_CALL, // operand = string of arginfo
 
+    // chain of additions (`a + b + c + ...`), with all the values present in stack;
+    // operand = count of values.
+    // Performed as one call if the `+` of the first value is a native variadic function
+    // (as for strings), otherwise as the separate `+` calls from left to right.
+    ADD_CHAIN,
+
     LAST, // used only as a case in execution
 };
 
@@ -65,22 +71,62 @@ enum class DataType : uint8_t
     IDEN,
 };
 
+// Inline cache of an ATTR instruction - the position of the attribute in the layout of the struct
+// (definition) with which the instruction was last executed.
+// The struct id and the position are packed in one value, so that the threads executing the same
+// bytecode never see a mismatched pair.
+class AttrCache
+{
+    mutable Atomic<uint64_t> val;
+
+    static constexpr size_t POS_BITS = 16;
+
+public:
+    AttrCache() : val(0) {}
+    AttrCache(const AttrCache &other) : val(other.val.load(std::memory_order_relaxed)) {}
+    AttrCache &operator=(const AttrCache &other)
+    {
+        val.store(other.val.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        return *this;
+    }
+
+    // Returns the position cached for the struct `id`, or -1 if there's none.
+    inline size_t get(size_t id) const
+    {
+        uint64_t v = val.load(std::memory_order_relaxed);
+        if(v == 0 || (v >> POS_BITS) != getKey(id)) return -1;
+        return v & ((1 << POS_BITS) - 1);
+    }
+    inline void set(size_t id, size_t pos) const
+    {
+        uint64_t key = getKey(id);
+        // positions and ids which don't fit are just not cached
+        if(pos >= (1 << POS_BITS) || key >= ((uint64_t)1 << (64 - POS_BITS))) return;
+        val.store((key << POS_BITS) | pos, std::memory_order_relaxed);
+    }
+
+private:
+    // Struct ids are generated downwards from SIZE_MAX, so this is small (and never 0).
+    static inline uint64_t getKey(size_t id) { return SIZE_MAX - id + 1; }
+};
+
 class FER_API Instruction
 {
 public:
-    using Data = Variant<String, int64_t, double, bool>;
+    // String data is owned by the Bytecode which contains the instruction.
+    using Data = Variant<StringRef, int64_t, double, bool>;
 
 private:
     Data data;
-    String comment;
+    StringRef comment;
     ModuleLoc loc;
     size_t index;
+    AttrCache attrCache; // only used by ATTR
     DataType dtype;
     Opcode opcode;
 
 public:
-    Instruction(Opcode opcode, ModuleLoc loc, DataType dtype, String &&data, String &&comment);
-    Instruction(Opcode opcode, ModuleLoc loc, DataType dtype, StringRef data, String &&comment);
+    Instruction(Opcode opcode, ModuleLoc loc, DataType dtype, StringRef data, StringRef comment);
     Instruction(Opcode opcode, ModuleLoc loc, int64_t data);
     Instruction(Opcode opcode, ModuleLoc loc, double data);
     Instruction(Opcode opcode, ModuleLoc loc, bool data);
@@ -96,17 +142,17 @@ public:
     isDataX(Iden, IDEN);
 
     inline void setInt(int64_t dat) { data = dat; }
-    inline void setStr(String &&dat) { data = std::move(dat); }
-    inline void setComment(String &&dat) { comment = std::move(dat); }
+    inline void setStr(StringRef dat) { data = dat; }
     inline void setComment(StringRef dat) { comment = dat; }
 
     inline ModuleLoc getLoc() const { return loc; }
     inline size_t getIndex() const { return index; }
-    inline StringRef getDataStr() const { return std::get<String>(data); }
+    inline StringRef getDataStr() const { return std::get<StringRef>(data); }
     inline int64_t getDataInt() const { return std::get<int64_t>(data); }
     inline double getDataFlt() const { return std::get<double>(data); }
     inline bool getDataBool() const { return std::get<bool>(data); }
 
+    inline const AttrCache &getAttrCache() const { return attrCache; }
     inline const Data &getData() const { return data; }
     inline StringRef getComment() const { return comment; }
     inline bool hasComment() const { return !comment.empty(); }
@@ -117,31 +163,60 @@ public:
 
     void dump(OStream &os) const;
     String dump() const;
-
-    static bool readFromFile(FILE *f, size_t moduleId, Instruction &ins);
-    void writeToFile(FILE *f) const;
 };
 
+// Version of the bytecode file format - must be incremented whenever the format (or the meaning of
+// the instructions) changes, so that the old bytecode files are discarded.
+constexpr uint32_t BYTECODE_FORMAT_VERSION = 2;
+
 class FER_API Bytecode
 {
     Vector<Instruction> code;
+    // Storage for the strings (operands, comments) of the instructions generated by codegen.
+    // A deque since the instructions refer to the strings, so they must never be moved.
+    Deque<String> strings;
+    // The bytecode file, if the instructions were loaded from one. The string operands of the
+    // instructions refer to its string table.
+    MappedFile mapping;
+
+    inline StringRef addString(String &&str)
+    {
+        if(str.empty()) return {};
+        return strings.emplace_back(std::move(str));
+    }
+    inline StringRef addString(StringRef str)
+    {
+        if(str.empty()) return {};
+        return strings.emplace_back(str);
+    }
 
 public:
+    Bytecode() = default;
+    Bytecode(Bytecode &&other)      = default;
+    Bytecode(const Bytecode &other) = delete;
+
+    Bytecode &operator=(Bytecode &&other)      = default;
+    Bytecode &operator=(const Bytecode &other) = delete;
+
     inline void addInstrStr(Opcode opcode, ModuleLoc loc, String &&data, String &&comment = "")
     {
-        code.emplace_back(opcode, loc, DataType::STR, std::move(data), std::move(comment));
+        code.emplace_back(opcode, loc, DataType::STR, addString(std::move(data)),
+                          addString(std::move(comment)));
     }
     inline void addInstrStr(Opcode opcode, ModuleLoc loc, StringRef data, String &&comment = "")
     {
-        code.emplace_back(opcode, loc, DataType::STR, data, std::move(comment));
+        code.emplace_back(opcode, loc, DataType::STR, addString(data),
+                          addString(std::move(comment)));
     }
     inline void addInstrIden(Opcode opcode, ModuleLoc loc, String &&data, String &&comment = "")
     {
-        code.emplace_back(opcode, loc, DataType::IDEN, std::move(data), std::move(comment));
+        code.emplace_back(opcode, loc, DataType::IDEN, addString(std::move(data)),
+                          addString(std::move(comment)));
     }
     inline void addInstrIden(Opcode opcode, ModuleLoc loc, StringRef data, String &&comment = "")
     {
-        code.emplace_back(opcode, loc, DataType::IDEN, data, std::move(comment));
+        code.emplace_back(opcode, loc, DataType::IDEN, addString(data),
+                          addString(std::move(comment)));
     }
     inline void addInstrInt(Opcode opcode, ModuleLoc loc, int64_t data)
     {
@@ -160,7 +235,7 @@ public:
     inline void updateInstrInt(size_t instrIdx, int64_t data) { code[instrIdx].setInt(data); }
     inline void updateInstrStr(size_t instrIdx, String &&data)
     {
-        code[instrIdx].setStr(std::move(data));
+        code[instrIdx].setStr(addString(std::move(data)));
     }
 
     inline void pop() { code.pop_back(); }
@@ -173,8 +248,21 @@ public:
 
     void dump(OStream &os) const;
 
-    static bool readFromFile(FILE *f, size_t moduleId, Bytecode &bc);
-    void writeToFile(FILE *f) const;
+    // Memory maps the bytecode file at `path` and loads the instructions from it.
+    // Fails (without modifying `bc`) if the file is not a valid bytecode file, is corrupted, or was
+    // generated by a different feral build or from a source other than `source`.
+    static bool readFromFile(const char *path, ModuleId moduleId, StringRef source, Bytecode &bc);
+    // Same as readFromFile(), but for bytecode file contents which are already in memory (like in a
+    // bundle). `file` must be 8 byte aligned and must outlive `bc`.
+    static bool read(StringRef file, ModuleId moduleId, StringRef source, Bytecode &bc);
+    // `source` is the source code from which this bytecode was generated.
+    bool writeToFile(FILE *f, StringRef source) const;
+    // Appends the bytecode file contents to `out`.
+    void write(String &out, StringRef source) const;
+
+    // Identifies the feral build (version, commit, compiler, ...) - stable across rebuilds of the
+    // same (clean) source tree.
+    static uint64_t getBuildId();
 };
 
 } // namespace fer
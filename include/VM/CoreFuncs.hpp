@@ -4,8 +4,10 @@ namespace fer
 {
 
 FERAL_FUNC_DECL(loadFile, 1, false,
-                "  fn(file) -> Module\n"
-                "Imports a feral script `file` and returns the imported Module.");
+                "  fn(file, lazy = nil) -> Module\n"
+                "Imports a feral script `file` and returns the imported Module.\n"
+                "If `lazy` is true, the module is imported when one of its attributes is first "
+                "used. By default, it's true only if feral is run with `--lazy`.");
 
 FERAL_FUNC_DECL(loadLibrary, 1, false,
                 "  fn(file) -> Nil\n"
@@ -5,26 +5,44 @@
 namespace fer
 {
 
+// Slots of the exec stack hold either counted references, or borrowed (uncounted) ones.
+// A borrowed slot refers to a var owned by a local var frame of the VM, so it is valid for as long
+// as the frame keeps it. Frames pin the borrowed slots (see pin()) before releasing any var, see
+// VirtualMachine::decFrameVarRef().
 class ExecStack : public IAllocated
 {
     Vector<Var *> stack;
     VirtualMachine &vm;
+    // No slot below this index is borrowed.
+    size_t pinnedTill;
+
+    static inline bool isBorrowed(Var *slot) { return (uintptr_t)slot & 1; }
+    static inline Var *untag(Var *slot) { return (Var *)((uintptr_t)slot & ~(uintptr_t)1); }
 
 public:
     ExecStack(VirtualMachine &vm);
     ~ExecStack();
 
     void push(Var *val, bool iref = true);
+    // Push a var owned by a frame without counting the reference.
+    inline void pushBorrowed(Var *val) { stack.push_back((Var *)((uintptr_t)val | 1)); }
+    inline void pushSlot(Var *val, bool counted) { counted ? push(val, false) : pushBorrowed(val); }
+    // With dref = false, the returned reference is counted (borrowed ones are promoted).
     Var *pop(bool dref = true);
+    // Pop without changing the reference count, counted tells if the slot held a counted one.
+    Var *popSlot(bool &counted);
+    // Pop (and release) slots till only `count` slots remain.
+    void popTill(size_t count);
+    // Count all the borrowed references in the stack.
+    void pin();
 
-    inline Var *back() { return stack.back(); }
-    inline Vector<Var *> &get() { return stack; }
+    inline Var *back() { return untag(stack.back()); }
+    inline Var *at(size_t idx) { return untag(stack[idx]); }
 
     inline size_t size() const { return stack.size(); }
     inline bool empty() const { return stack.empty(); }
-    inline void clear() { stack.clear(); }
 
     String dump(VirtualMachine *vm);
 };
 
-} // namespace fer
\ No newline at end of file
+} // namespace fer
@@ -1,7 +1,9 @@
 #pragma once
 
+#include "AllocProfiler.hpp"
 #include "Args.hpp"
-#include "VarTypes.hpp"
+#include "Bundle.hpp"
+#include "ImportCache.hpp"
 
 #if defined(FER_OS_WINDOWS)
 #include <chrono>    // because MSVC complains about missing header while Linux doesn't :shrug:
@@ -51,9 +53,17 @@ class FER_API GlobalState
     VarNil *nil;
     // Imports
     Map<ModuleId, VarModule *> modules;
+    // Index of modules by their path (the first loaded module for a path)
+    StringMap<VarModule *> modulePaths;
+    // Resolved imports, for skipping the module finders on repeated import() calls
+    ImportCache importCache;
+    // Only present if the program is run from a bundle (source file has the bundle extension)
+    Bundle *bundle;
     // This is the one that's used for checking, and it can be modified by Feral program
     size_t recurseMax;
     Atomic<bool> stopExec;
+    // Only present if allocation profiling is enabled (--allocprof)
+    AllocProfiler *allocProfiler;
 
     friend class VirtualMachine;
 
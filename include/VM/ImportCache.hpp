@@ -0,0 +1,51 @@
+#pragma once
+
+#include "VarTypes.hpp"
+
+namespace fer
+{
+
+constexpr size_t IMPORT_CACHE_SLOTS = 1024;
+
+// Cache of resolved imports: (import string, path of the importing module, search hash) -> module.
+// The search hash is computed from the module dirs and finders, so changing them makes the existing
+// entries unreachable and the imports are resolved again.
+// Lookups are lock free so that `import()` calls in hot paths don't have to take the module
+// loading lock and run the module finders again. Inserts are expected to happen under the module
+// loading lock.
+// The cached modules are not ref counted since imported modules are held by the globals until
+// the end of the program. Entries are therefore only removed by clear() (at deinit).
+class FER_API ImportCache
+{
+    struct Entry : public IAllocated
+    {
+        String name;
+        String srcPath;
+        VarModule *mod;
+        size_t searchHash;
+        size_t hash;
+
+        Entry(StringRef name, StringRef srcPath, VarModule *mod, size_t searchHash, size_t hash);
+        bool matches(StringRef name, StringRef srcPath, size_t searchHash, size_t hash) const;
+    };
+
+    MemoryManager &mem;
+    // Open addressing (linear probing) table. Once set, a slot is never changed until clear().
+    Array<Atomic<Entry *>, IMPORT_CACHE_SLOTS> slots;
+    Atomic<size_t> count;
+
+    static size_t getHash(StringRef name, StringRef srcPath, size_t searchHash);
+
+public:
+    ImportCache(MemoryManager &mem);
+    ~ImportCache();
+
+    VarModule *get(StringRef name, StringRef srcPath, size_t searchHash);
+    // Does nothing if the entry already exists or the cache is (nearly) full.
+    void set(StringRef name, StringRef srcPath, size_t searchHash, VarModule *mod);
+    void clear();
+
+    inline size_t size() { return count.load(std::memory_order_relaxed); }
+};
+
+} // namespace fer
@@ -92,6 +92,8 @@ class FER_API VirtualMachine : public IAllocated
     String name;
     Vector<VarModule *> modulestack;
     Set<Var *> refVars; // vars that are marked for ref.
+    // ModuleLoc's of the active calls - only maintained when allocation profiling is enabled.
+    Vector<ModuleLoc> callLocs;
     VarStack *vars;
     FailStack *failstack;
     ExecStack *execstack;
@@ -120,6 +122,11 @@ public:
                      VarMap *assnArgs);
 
     int compileAndRun(ModuleLoc loc, const char *file, VarModule **module);
+    // Compiles the main file, the prelude, and all the modules imported by them (without running
+    // any of them) into a bundle at outFile.
+    // Only the imports with a constant string argument can be found - others are resolved normally
+    // when the bundle is run.
+    bool createBundle(ModuleLoc loc, const Path &mainFile, const char *outFile);
     // Must pushModule, pushFn/pushBlk before calling this function,
     // and popModule, popFn/popBlk after calling it.
     int execute(Var *&ret, size_t *currentlyAt = nullptr, size_t begin = 0, size_t end = 0);
@@ -127,6 +134,8 @@ public:
     VarModule *makeModule(ModuleLoc loc, File *f, bool exprOnly, bool isVirtual);
     void pushModule(VarModule *module);
     void popModule();
+    // Removes the module from the list (and path index) of loaded modules.
+    void removeModule(VarModule *mod);
 
     VarFn *makeFn(ModuleLoc loc, const FeralNativeFnDesc &fnObj);
 
@@ -173,6 +182,13 @@ public:
     // evaluate a given expression and return its result
     // primarily used for templates
     Var *eval(ModuleLoc loc, StringRef code, bool isExpr);
+    // Same as eval(), split in two steps so that the code can be compiled once and evaluated any
+    // number of times (like in the compiled string templates).
+    // The module returned by compileEval() has no references, and must be released using
+    // releaseEvalModule() once the caller's reference to it is no longer needed.
+    VarModule *compileEval(ModuleLoc loc, StringRef code, bool isExpr);
+    Var *evalModule(ModuleLoc loc, VarModule *mod);
+    void releaseEvalModule(VarModule *mod);
 
     inline Var *markRef(Var *var)
     {
@@ -185,6 +201,8 @@ public:
     inline void clearRefVarsFrame() { refVars.clear(); }
 
     inline StringRef getName() { return name; }
+    inline const Vector<ModuleLoc> &getCallLocs() { return callLocs; }
+    inline AllocProfiler *getAllocProfiler() { return gs->allocProfiler; }
 
     inline VarStack *getVars() { return vars; }
     inline VarModule *getCurrModule() { return modulestack.back(); }
@@ -200,6 +218,8 @@ public:
     inline MemoryManager &getMemoryManager() { return gs->mem; }
     inline VarVec *getModuleDirs() { return gs->moduleDirs; }
     inline VarVec *getModuleFinders() { return gs->moduleFinders; }
+    inline ImportCache &getImportCache() { return gs->importCache; }
+    inline Bundle *getBundle() { return gs->bundle; }
     inline VarPath *getBinaryPath() { return gs->binaryPath; }
     inline VarPath *getInstallPath() { return gs->installPath; }
     inline VarPath *getTempPath() { return gs->tempPath; }
@@ -239,7 +259,11 @@ public:
     // makeVar => createVar + initVar
     template<VarDerived T, typename... Args> T *createVar(ModuleLoc loc, Args &&...args)
     {
-        T *res = new(gs->mem.allocRaw(sizeof(T), alignof(T))) T(loc, std::forward<Args>(args)...);
+        void *mem      = gs->mem.allocRaw(sizeof(T), alignof(T));
+        size_t allocSz = gs->mem.getAllocSize(mem);
+        if(gs->mem.hasStats()) gs->mem.tagAlloc(typeID<T>(), allocSz);
+        if(gs->allocProfiler) gs->allocProfiler->onAlloc(*this, loc, typeID<T>(), allocSz);
+        T *res = new(mem) T(loc, std::forward<Args>(args)...);
         res->create(*this);
         return res;
     }
@@ -266,13 +290,23 @@ public:
     {
         if(var == nullptr) return nullptr;
         if(var->dref() <= 0 && del) {
-            var->deinit(*this);
-            var->destroy(*this);
-            gs->mem.freeDeinit(var);
+            unmakeVar(var);
             var = nullptr;
         }
         return var;
     }
+    // Deinitializes and destroys the var, regardless of its reference count.
+    inline void unmakeVar(Var *var)
+    {
+        var->deinit(*this);
+        var->destroy(*this);
+        if(gs->mem.hasStats()) gs->mem.tagFree(var->getType(), gs->mem.getAllocSize(var));
+        gs->mem.freeDeinit(var);
+    }
+
+    // Same as decVarRef(), for the vars released by a var frame of this VM. The exec stack may
+    // hold borrowed references to them, so those are counted first (see ExecStack::pin()).
+    void decFrameVarRef(Var *var);
 
     template<VarDerived T, typename... Args>
     bool makeGlobal(ModuleLoc loc, StringRef name, StringRef doc, Args &&...args)
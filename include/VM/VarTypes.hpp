@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Bytecode.hpp"
+#include "OrderedHashMap.hpp"
 
 namespace fer
 {
@@ -236,12 +237,27 @@ public:
     inline double getVal() { return val; }
 };
 
+// Strings of at least this length are shared (copy-on-write) by copies and substrings, instead
+// of being copied. Such strings are put in a shared buffer when they are created, so that making
+// a copy only reads the source string (other threads may be reading it at the same time).
+constexpr size_t STR_SHARE_MIN_LEN = 64;
+
 class FER_API VarStr : public Var
 {
     String val;
+    // If set, the contents are `count` bytes from `offset` in this buffer (and `val` is unused).
+    // The buffer is never modified; getVal() first moves / copies it in `val`.
+    SharedPtr<String> shared;
+    size_t offset;
+    size_t count;
 
     bool onSet(VirtualMachine &vm, Var *from) override;
 
+    // Moves `val` to a shared buffer if it is long enough.
+    void initShared();
+    void share(VarStr *src, size_t pos, size_t len);
+    void unshare();
+
 public:
     VarStr(ModuleLoc loc, char val);
     VarStr(ModuleLoc loc, String &&val);
@@ -249,9 +265,30 @@ public:
     VarStr(ModuleLoc loc, const char *val);
     VarStr(ModuleLoc loc, InitList<StringRef> _val);
     VarStr(ModuleLoc loc, const char *val, size_t count);
+    // Substring of `src` - shares the buffer with it if the substring is long enough.
+    VarStr(ModuleLoc loc, VarStr *src, size_t pos = 0, size_t len = String::npos);
+
+    // Drops `front` characters from the beginning and `back` from the end (without copying).
+    void shrink(size_t front, size_t back);
 
-    inline void setVal(StringRef newval) { val = newval; }
-    inline String &getVal() { return val; }
+    inline void setVal(StringRef newval)
+    {
+        shared.reset();
+        val = newval;
+        initShared();
+    }
+    // For modifying the string. Copies the contents first if they are shared, so the returned
+    // reference must not be used after `this` is copied or substr'd.
+    inline String &getVal()
+    {
+        if(shared) unshare();
+        return val;
+    }
+    // For reading the string, never copies.
+    inline StringRef getView() const
+    {
+        return shared ? StringRef(shared->data() + offset, count) : StringRef(val);
+    }
 };
 
 class FER_API VarVec : public Var
@@ -300,43 +337,40 @@ public:
     bool next(Var *&val);
 };
 
+// All maps keep their keys in the insertion order, `ordered` is kept only for the reflection
+// (`Map.isOrdered()`).
 class FER_API VarMap : public Var
 {
-    StringMap<Var *> val;
-    ManagedRawList *keyOrder; // list<str>
+    OrderedStringMap<Var *> val;
     bool ordered;
     bool asrefs;
 
-    void onCreate(VirtualMachine &vm) override;
     void onDestroy(VirtualMachine &vm) override;
     bool onSet(VirtualMachine &vm, Var *from) override;
 
 public:
+    // Position based, so it stays valid when the map is modified while iterating, as long as the
+    // positions are pinned (see VarMapIterator) when entries may be erased and then inserted.
     class Iterator
     {
-        void *orderiter;
-        StringMap<Var *>::iterator dataiter;
-        bool forward;
+        OrderedStringMap<Var *> *map;
+        size_t pos;
 
         friend class VarMap;
 
     public:
-        Iterator(void *orderiter, StringMap<Var *>::iterator dataiter, bool forward);
+        Iterator(OrderedStringMap<Var *> *map, size_t pos);
 
-        inline bool operator==(const Iterator &other) const
-        {
-            return orderiter == other.orderiter && dataiter == other.dataiter;
-        }
-        inline bool operator!=(const Iterator &other) const { return !(*this == other); }
+        inline bool operator==(const Iterator &other) const { return pos == other.pos; }
+        inline bool operator!=(const Iterator &other) const { return pos != other.pos; }
 
-        inline StringRef key() { return dataiter->first; }
-        inline Var *val() { return dataiter->second; }
-        inline bool isForward() { return forward; }
+        inline StringRef key() { return map->getAt(pos).first; }
+        inline Var *val() { return map->getAt(pos).second; }
     };
 
     VarMap(ModuleLoc loc, bool ordered, bool asrefs);
 
-    bool setVal(VirtualMachine &vm, const StringMap<Var *> &newval, ManagedRawList *order);
+    bool setVal(VirtualMachine &vm, OrderedStringMap<Var *> &newval);
     void clear(VirtualMachine &vm);
 
     // not inline because Var is incomplete type
@@ -348,18 +382,16 @@ public:
     void getAttrList(VirtualMachine &vm, VarVec *dest) override;
     inline size_t getAttrCount() override { return val.size(); }
 
-    Iterator begin(bool forward = true);
-    inline Iterator end() { return Iterator(nullptr, val.end(), false); }
+    Iterator begin();
+    inline Iterator end() { return Iterator(&val, SIZE_MAX); }
     void next(Iterator &it);
-
-    void addOrder(StringRef name);
-    void remOrder(StringRef name);
+    // Moves `it` past the entries erased since it was last advanced.
+    void revalidate(Iterator &it);
 
     inline void reserve(size_t count) { val.reserve(count); }
 
     inline size_t size() { return val.size(); }
-    inline StringMap<Var *> &getVal() { return val; }
-    inline ManagedRawList *getOrder() { return keyOrder; }
+    inline OrderedStringMap<Var *> &getVal() { return val; }
     inline bool isOrdered() { return ordered; }
     inline bool isRefMap() { return asrefs; }
     inline bool empty() { return val.empty(); }
@@ -379,6 +411,56 @@ public:
     bool next(VirtualMachine &vm, ModuleLoc loc, Var *&val);
 };
 
+// Hash map with keys of any hashable type - Int, Flt, Str, Bool and Nil are hashed and compared
+// natively, and structs through their `hash()` and `==` member functions. Keys of different types
+// are never equal (so `1` and `1.0` are different keys).
+// Like VarMap, the entries are kept in the insertion order.
+class FER_API VarHashMap : public Var
+{
+public:
+    using Entry = OrderedHashMap<Var *, Var *>::Entry;
+
+private:
+    OrderedHashMap<Var *, Var *> val;
+    bool asrefs;
+
+    void onDestroy(VirtualMachine &vm) override;
+    bool onSet(VirtualMachine &vm, Var *from) override;
+
+public:
+    VarHashMap(ModuleLoc loc, bool asrefs);
+
+    // All of these fail (and return false) if the key can't be hashed or compared.
+    // `res` is set to nullptr if the key does not exist.
+    bool find(VirtualMachine &vm, ModuleLoc loc, Var *key, Entry *&res);
+    // A copy of the key is stored, while the reference to val is taken over (unless it fails).
+    bool insert(VirtualMachine &vm, ModuleLoc loc, Var *key, Var *val);
+    bool erase(VirtualMachine &vm, ModuleLoc loc, Var *key);
+    void clear(VirtualMachine &vm);
+
+    inline void reserve(size_t count) { val.reserve(count); }
+
+    inline size_t size() { return val.size(); }
+    inline bool empty() { return val.empty(); }
+    inline bool isRefMap() { return asrefs; }
+    inline OrderedHashMap<Var *, Var *> &getVal() { return val; }
+};
+
+class FER_API VarHashMapIterator : public Var
+{
+    VarHashMap *map;
+    size_t pos;
+
+    void onCreate(VirtualMachine &vm) override;
+    void onDestroy(VirtualMachine &vm) override;
+
+public:
+    VarHashMapIterator(ModuleLoc loc, VarHashMap *map);
+
+    // Returns false if nothing's left. val is nullptr if copying the key failed.
+    bool next(VirtualMachine &vm, ModuleLoc loc, Var *&val);
+};
+
 typedef Var *(*NativeFn)(VirtualMachine &vm, ModuleLoc loc, Span<Var *> args, VarMap *assnArgs);
 
 class FeralNativeFnDesc
@@ -561,12 +643,19 @@ class FER_API VarModule : public Var
     ModuleId moduleId;
     VarFrame *moduleFrame;
     bool virtualMod; // if is virtual, no module frame is generated for it
+    // A lazy module is a proxy for the module at path, which is imported on the first attribute
+    // access through the VM (see loadLazyModule()). The module frame is then shared with it.
+    Atomic<bool> lazy;
 
     void onCreate(VirtualMachine &vm) override;
     void onDestroy(VirtualMachine &vm) override;
 
+    bool importLazy(VirtualMachine &vm, ModuleLoc loc);
+
 public:
     VarModule(ModuleLoc loc, StringRef path, Bytecode &&bc, ModuleId moduleId, bool isVirtual);
+    // Creates a lazy module
+    VarModule(ModuleLoc loc, StringRef path);
 
     // not inline because Vars is incomplete type
     void setAttr(VirtualMachine &vm, StringRef name, Var *val, bool iref) override;
@@ -581,6 +670,11 @@ public:
     inline ModuleId getModuleId() { return moduleId; }
     inline VarFrame *getVarFrame() { return moduleFrame; }
     inline bool isVirtual() { return virtualMod; }
+    inline bool isLazy() { return lazy.load(std::memory_order_acquire); }
+    // Imports the module if it's lazy. Returns false if the import fails.
+    inline bool load(VirtualMachine &vm, ModuleLoc loc) { return !isLazy() || importLazy(vm, loc); }
+    // Makes the lazy module a proxy for the imported module mod.
+    void setImported(VirtualMachine &vm, VarModule *mod);
 };
 
 class FER_API VarDll : public Var
@@ -634,49 +728,83 @@ public:
     inline size_t getSubType() override { return id; }
     inline size_t getID() { return id; }
 
+    // The attributes (in their order) are the layout of the fields of the struct instances.
+    // Attributes are never removed from a definition, so the positions don't change.
+    // Returns -1 if `name` is not a field.
+    size_t getFieldIndex(StringRef name);
+    inline StringRef getFieldName(size_t idx) { return attrs->getVal().getAt(idx).first; }
+
     inline void reserveAttrs(size_t count) { return attrs->reserve(count); }
 };
 
+// The fields of a struct instance are stored in an array, in the layout defined by its base.
+// Attributes which are not in the layout (like the ones added after creating the instance, or all
+// of them for structs without a base, like enums) are stored in a map instead.
 class FER_API VarStruct : public Var
 {
     VarStructDef *base;
-    VarMap *attrs;
+    Vector<Var *> fields;
+    VarMap *extra; // nullptr until required
     size_t id;
 
     void onCreate(VirtualMachine &vm) override;
     void onDestroy(VirtualMachine &vm) override;
     bool onSet(VirtualMachine &vm, Var *from) override;
 
+    // Returns -1 if `name` is not in the fields (of this instance).
+    inline size_t getFieldIndex(StringRef name)
+    {
+        if(!base) return -1;
+        size_t idx = base->getFieldIndex(name);
+        return idx < fields.size() ? idx : -1;
+    }
+    VarMap *getExtra(VirtualMachine &vm);
+
 public:
     // base can be nullptr (as is the case for enums)
     VarStruct(ModuleLoc loc, VarStructDef *base);
     // base can be nullptr (as is the case for enums)
     VarStruct(ModuleLoc loc, VarStructDef *base, size_t id);
 
-    inline void setAttr(VirtualMachine &vm, StringRef name, Var *val, bool iref) override
-    {
-        return attrs->setAttr(vm, name, val, iref);
-    }
-    inline bool replaceAttr(VirtualMachine &vm, StringRef name, Var *val, bool iref) override
+    void setAttr(VirtualMachine &vm, StringRef name, Var *val, bool iref) override;
+    bool replaceAttr(VirtualMachine &vm, StringRef name, Var *val, bool iref) override;
+    bool existsAttr(StringRef name) override;
+    Var *getAttr(StringRef name) override;
+    void getAttrList(VirtualMachine &vm, VarVec *dest) override;
+    inline size_t getAttrCount() override
     {
-        return attrs->replaceAttr(vm, name, val, iref);
+        return fields.size() + (extra ? extra->size() : 0);
     }
-    inline bool existsAttr(StringRef name) override { return attrs->existsAttr(name); }
-    inline Var *getAttr(StringRef name) override { return attrs->getAttr(name); }
-    inline void getAttrList(VirtualMachine &vm, VarVec *dest) override
+
+    // Same as getAttr(), but the position of the field is taken from (or stored in) `cache`
+    // instead of looking up `name` in the base.
+    Var *getAttrCached(StringRef name, const AttrCache &cache);
+    // Sets the field at `idx` (in the layout of base), taking over the reference to `val`.
+    void setField(VirtualMachine &vm, size_t idx, Var *val);
+    inline bool hasField(size_t idx) { return fields[idx] != nullptr; }
+
+    // Calls fn(name, value) for each attribute - the fields (in the layout order) and then the
+    // remaining ones (in the insertion order), until fn() returns false.
+    // Returns false if it was stopped by fn().
+    template<typename F> bool forEachAttr(F &&fn)
     {
-        return attrs->getAttrList(vm, dest);
+        for(size_t i = 0; i < fields.size(); ++i) {
+            if(!fn(base->getFieldName(i), fields[i])) return false;
+        }
+        if(!extra) return true;
+        for(auto &e : extra->getVal()) {
+            if(!fn(StringRef(e.first), e.second)) return false;
+        }
+        return true;
     }
-    inline size_t getAttrCount() override { return attrs->size(); }
-
-    inline VarMap::Iterator attrBegin() { return attrs->begin(); }
-    inline VarMap::Iterator attrEnd() { return attrs->end(); }
-    inline void attrNext(VarMap::Iterator &it) { return attrs->next(it); }
 
     inline size_t getSubType() override { return id; }
     inline VarStructDef *getBase() { return base; }
 
-    inline void reserveAttrs(size_t count) { return attrs->reserve(count); }
+    inline void reserveAttrs(size_t count)
+    {
+        if(!base) extra->reserve(count);
+    }
 };
 
 class FER_API VarFailure : public Var
@@ -841,6 +969,55 @@ public:
     inline size_t capacity() { return bufsz; }
 };
 
+// Growable buffer for building a string piece by piece.
+// Unlike `+`, appending never copies the existing contents (except for the amortized growth).
+class FER_API VarStrBuilder : public Var
+{
+    String buf;
+
+    bool onSet(VirtualMachine &vm, Var *from) override;
+
+public:
+    VarStrBuilder(ModuleLoc loc, size_t reservesz);
+
+    inline String &getVal() { return buf; }
+};
+
+// String template made by `Str.compileFormat()`.
+// The template is split into literal text and placeholders once, and each placeholder expression
+// is compiled to a module once, so rendering it only runs the compiled code and appends.
+class FER_API VarStrTemplate : public Var
+{
+public:
+    struct Placeholder
+    {
+        String prefix; // literal text before the placeholder
+        String expr;
+        VarModule *mod;
+        // set if the expression is just a variable name, which is looked up without running mod
+        StringRef iden;
+    };
+
+private:
+    Vector<Placeholder> placeholders;
+    String suffix; // literal text after the last placeholder
+
+    void onDestroy(VirtualMachine &vm) override;
+    bool onSet(VirtualMachine &vm, Var *from) override;
+
+public:
+    VarStrTemplate(ModuleLoc loc);
+
+    // Takes ownership of the reference to the module.
+    void addPlaceholder(String &&prefix, StringRef expr, VarModule *mod);
+    inline void setSuffix(String &&text) { suffix = std::move(text); }
+
+    inline Span<Placeholder> getPlaceholders() { return placeholders; }
+    inline StringRef getSuffix() { return suffix; }
+    // Length of all the literal text.
+    size_t getLiteralLen();
+};
+
 class FER_API VarStack : public Var
 {
     Vector<VarFrame *> stack;
@@ -866,6 +1043,9 @@ public:
     // use this instead of exists() if the Var* retrieval is actually required
     // and current scope requirement is not present
     Var *getAttr(StringRef name) override;
+    // local is set if the var is in one of the frames above the module frame, which (unlike the
+    // module frame) are only used by this VM.
+    Var *getAttr(StringRef name, bool &local);
 
     void pushBlk(VirtualMachine &vm, ModuleLoc loc, size_t count);
     void popBlk(VirtualMachine &vm, size_t count);
@@ -16,6 +16,7 @@
 #include "Incs/Error.hpp.in"
 #include "Incs/File.hpp.in"
 #include "Incs/Flt.hpp.in"
+#include "Incs/HashMap.hpp.in"
 #include "Incs/Int.hpp.in"
 #include "Incs/Map.hpp.in"
 #include "Incs/Module.hpp.in"
@@ -23,6 +24,8 @@
 #include "Incs/Path.hpp.in"
 #include "Incs/Result.hpp.in"
 #include "Incs/Str.hpp.in"
+#include "Incs/StrBuilder.hpp.in"
+#include "Incs/StrTemplate.hpp.in"
 #include "Incs/Struct.hpp.in"
 #include "Incs/TypeID.hpp.in"
 #include "Incs/Vec.hpp.in"
@@ -80,7 +83,8 @@ FERAL_FUNC(allHasAttr, 1, false,
     EXPECT_ATTR_BASED(args[0], "var");
     EXPECT(VarStr, args[1], "attribute name");
     Var *in        = args[0];
-    StringRef attr = as<VarStr>(args[1])->getVal();
+    StringRef attr = as<VarStr>(args[1])->getView();
+    if(in->is<VarModule>() && !as<VarModule>(in)->load(vm, loc)) return nullptr;
     return in->existsAttr(attr) ? vm.getTrue() : vm.getFalse();
 }
 
@@ -92,8 +96,9 @@ FERAL_FUNC(allGetAttr, 1, false,
     EXPECT_ATTR_BASED(args[0], "var");
     EXPECT(VarStr, args[1], "attribute name");
     Var *in        = args[0];
-    StringRef attr = as<VarStr>(args[1])->getVal();
-    Var *res       = in->getAttr(attr);
+    StringRef attr = as<VarStr>(args[1])->getView();
+    if(in->is<VarModule>() && !as<VarModule>(in)->load(vm, loc)) return nullptr;
+    Var *res = in->getAttr(attr);
     if(!res) {
         vm.fail(loc, "attribute `", attr, "` not found");
         return nullptr;
@@ -107,7 +112,8 @@ FERAL_FUNC(allGetAttrs, 0, false,
            "Requires `var` to be attribute based (like Module / Struct).")
 {
     EXPECT_ATTR_BASED(args[0], "var");
-    Var *in     = args[0];
+    Var *in = args[0];
+    if(in->is<VarModule>() && !as<VarModule>(in)->load(vm, loc)) return nullptr;
     VarVec *res = vm.makeVar<VarVec>(loc, in->getAttrCount(), true);
     in->getAttrList(vm, res);
     return res;
@@ -122,7 +128,7 @@ FERAL_FUNC(allSetAttr, 2, false,
     EXPECT_ATTR_BASED(args[0], "var");
     EXPECT(VarStr, args[1], "attribute name");
     Var *in        = args[0];
-    StringRef attr = as<VarStr>(args[1])->getVal();
+    StringRef attr = as<VarStr>(args[1])->getView();
     in->setAttr(vm, attr, args[2], true);
     return args[2];
 }
@@ -352,7 +358,7 @@ FERAL_FUNC(raise, 1, true,
         Var *v = nullptr;
         Array<Var *, 1> tmp{args[i]};
         if(!vm.callVarAndExpect<VarStr>(loc, "str", v, tmp, {})) return nullptr;
-        res += as<VarStr>(v)->getVal();
+        res += as<VarStr>(v)->getView();
         vm.decVarRef(v);
     }
     vm.fail(loc, "Raised: ", res);
@@ -364,7 +370,7 @@ FERAL_FUNC(evalCode, 1, false,
            "Evaluates the given code and returns the result.")
 {
     EXPECT(VarStr, args[1], "code");
-    StringRef code = as<VarStr>(args[1])->getVal();
+    StringRef code = as<VarStr>(args[1])->getView();
     Var *res       = vm.eval(loc, code, false);
     if(!res) {
         vm.fail(loc, "failed to evaluate code: ", code);
@@ -379,7 +385,7 @@ FERAL_FUNC(evalExpr, 1, false,
            "Unlike `eval()`, this just expects an expression and doesn't need a return statement.")
 {
     EXPECT(VarStr, args[1], "code");
-    StringRef expr = as<VarStr>(args[1])->getVal();
+    StringRef expr = as<VarStr>(args[1])->getView();
     Var *res       = vm.eval(loc, expr, true);
     if(!res) {
         vm.fail(loc, "failed to evaluate expr: ", expr);
@@ -478,12 +484,13 @@ FERAL_FUNC(varExists, 1, true,
            "If `varModule` is an instance of Module, checks within that too.")
 {
     EXPECT(VarStr, args[1], "variable name");
-    StringRef varName = as<VarStr>(args[1])->getVal();
+    StringRef varName = as<VarStr>(args[1])->getView();
     VarModule *mod    = vm.getCurrModule();
     bool providedMod  = false;
     if(args.size() > 2 && args[2]->is<VarModule>()) {
         mod         = as<VarModule>(args[2]);
         providedMod = true;
+        if(!mod->load(vm, loc)) return nullptr;
         return mod->getAttr(varName) ? vm.getTrue() : vm.getFalse();
     }
     VarStack *moduleVars = vm.getVars();
@@ -497,7 +504,7 @@ FERAL_FUNC(varReplace, 2, true,
            "Returns `true` on success, `false` if there is no variable with `name`.")
 {
     EXPECT(VarStr, args[1], "variable name");
-    StringRef varName = as<VarStr>(args[1])->getVal();
+    StringRef varName = as<VarStr>(args[1])->getView();
     Var *in           = vm.getVars();
     if(args.size() > 3 && args[3]->isAttrBased()) in = args[3];
     Var *cp = vm.copyVar(loc, args[2], false);
@@ -523,6 +530,97 @@ FERAL_FUNC(getMaxRecursion, 0, false,
     return vm.makeVar<VarInt>(loc, vm.getRecurseMax());
 }
 
+static VarMap *makeAllocCounterMap(VirtualMachine &vm, ModuleLoc loc, const AllocCounter &c)
+{
+    VarMap *res = vm.makeVar<VarMap>(loc, true, false);
+    res->setAttr(vm, "allocs", vm.makeVar<VarInt>(loc, c.allocs.load()), true);
+    res->setAttr(vm, "frees", vm.makeVar<VarInt>(loc, c.frees.load()), true);
+    res->setAttr(vm, "live", vm.makeVar<VarInt>(loc, c.live()), true);
+    res->setAttr(vm, "liveBytes", vm.makeVar<VarInt>(loc, c.liveBytes.load()), true);
+    return res;
+}
+
+FERAL_FUNC(memStats, 0, false,
+           "  fn() -> Map\n"
+           "Returns the live allocation statistics of the memory manager as a map containing:\n"
+           "- totals: `allocRequests`, `totalAllocBytes`, `poolAllocBytes`, `chunkReuses`\n"
+           "- pools: `poolCount`, `poolSize`, `poolUsedBytes`, `freeListBytes`\n"
+           "- `sizeClasses`: map of size class limit (or `large`) to its counters\n"
+           "- `types`: map of type name to its counters\n"
+           "Counters are maps with `allocs`, `frees`, `live` and `liveBytes`. They are only "
+           "collected with `--memstats`, otherwise `sizeClasses` and `types` are empty.")
+{
+    MemoryManager &mem = vm.getMemoryManager();
+    VarMap *res        = vm.makeVar<VarMap>(loc, true, false);
+    res->setAttr(vm, "allocRequests",
+                 vm.makeVar<VarInt>(loc, MemoryManager::getTotalAllocRequests()), true);
+    res->setAttr(vm, "totalAllocBytes",
+                 vm.makeVar<VarInt>(loc, MemoryManager::getTotalAllocBytes()), true);
+    res->setAttr(vm, "poolAllocBytes",
+                 vm.makeVar<VarInt>(loc, MemoryManager::getTotalPoolAlloc()), true);
+    res->setAttr(vm, "chunkReuses",
+                 vm.makeVar<VarInt>(loc, MemoryManager::getChunkReuseCount()), true);
+    res->setAttr(vm, "poolCount", vm.makeVar<VarInt>(loc, mem.getPoolCount()), true);
+    res->setAttr(vm, "poolSize", vm.makeVar<VarInt>(loc, mem.getPoolSize()), true);
+    res->setAttr(vm, "poolUsedBytes", vm.makeVar<VarInt>(loc, mem.getPoolUsedBytes()), true);
+    res->setAttr(vm, "freeListBytes", vm.makeVar<VarInt>(loc, mem.getFreeChunkBytes()), true);
+
+    VarMap *sizeClasses = vm.makeVar<VarMap>(loc, true, false);
+    auto &sizeStats     = mem.getSizeClassStats();
+    for(size_t i = 0; i < sizeStats.size(); ++i) {
+        if(sizeStats[i].allocs == 0) continue;
+        size_t limit = mem.getSizeClassLimit(i);
+        sizeClasses->setAttr(vm, limit ? std::to_string(limit) : "large",
+                             makeAllocCounterMap(vm, loc, sizeStats[i]), true);
+    }
+    res->setAttr(vm, "sizeClasses", sizeClasses, true);
+
+    VarMap *types = vm.makeVar<VarMap>(loc, false, false);
+    for(auto &c : mem.getTagStats()) {
+        if(c.tag == 0) continue;
+        StringRef name = c.tag == (size_t)-1 ? "<other>" : vm.getTypeName(c.tag);
+        types->setAttr(vm, name, makeAllocCounterMap(vm, loc, c), true);
+    }
+    res->setAttr(vm, "types", types, true);
+    return res;
+}
+
+FERAL_FUNC(dumpAllocProfile, 1, false,
+           "  fn(file) -> Bool\n"
+           "Writes the samples collected so far by the allocation profiler to `file` in folded stack "
+           "format.\n"
+           "Returns `false` if the profiler is not enabled (`--allocprof`) or the file couldn't "
+           "be written.")
+{
+    EXPECT2(VarStr, VarPath, args[1], "file");
+    AllocProfiler *profiler = vm.getAllocProfiler();
+    if(!profiler) return vm.getFalse();
+    String path = args[1]->is<VarStr>() ? as<VarStr>(args[1])->getVal()
+                                        : as<VarPath>(args[1])->toStr();
+    return profiler->dump(vm, path.c_str()) ? vm.getTrue() : vm.getFalse();
+}
+
+FERAL_FUNC(createBundle, 2, false,
+           "  fn(mainFile, outFile) -> Nil\n"
+           "Creates a bundle at `outFile` containing the program `mainFile` and all the modules "
+           "imported by it (including the prelude and std modules) in compiled form.\n"
+           "The bundle can be run using `feral <outFile>` if its extension is `.fbundle`.\n"
+           "Native modules are not stored in the bundle, but must be present at the same paths "
+           "(and be unchanged) when the bundle is run.")
+{
+    EXPECT2(VarStr, VarPath, args[1], "main file");
+    EXPECT2(VarStr, VarPath, args[2], "output file");
+    Path mainFile  = args[1]->is<VarStr>() ? Path(as<VarStr>(args[1])->getVal())
+                                           : as<VarPath>(args[1])->getVal();
+    String outFile = args[2]->is<VarStr>() ? String(as<VarStr>(args[2])->getVal())
+                                           : as<VarPath>(args[2])->toStr();
+    if(!vm.createBundle(loc, mainFile, outFile.c_str())) {
+        vm.fail(loc, "failed to create bundle: ", outFile);
+        return nullptr;
+    }
+    return vm.getNil();
+}
+
 FERAL_FUNC(
     addToModulePaths, 2, true,
     "  fn(modulePathsFile, paths...) -> Int\n"
@@ -644,7 +742,10 @@ INIT_DLL(Prelude)
     vm.addLocal(loc, "exitNative", exitNative);
     vm.addLocal(loc, "setMaxRecursionNative", setMaxRecursionNative);
     vm.addLocal(loc, "getMaxRecursion", getMaxRecursion);
+    vm.addLocal(loc, "memStats", memStats);
+    vm.addLocal(loc, "dumpAllocProfile", dumpAllocProfile);
     vm.addLocal(loc, "getCurrModule", getCurrModule);
+    vm.addLocal(loc, "createBundle", createBundle);
     vm.addLocal(loc, "getOSName", getOSName);
     vm.addLocal(loc, "getOSDistro", getOSDistro);
     // variadic as there can be no proxy for this function (to make args[2] (VarModule) optional)
@@ -652,7 +753,9 @@ INIT_DLL(Prelude)
     vm.addLocal(loc, "varReplace", varReplace);
     vm.addLocal(loc, "vecNew", vecNew);
     vm.addLocal(loc, "mapNew", mapNew);
+    vm.addLocal(loc, "hashMapNew", hashMapNew);
     vm.addLocal(loc, "bytebufferNew", bytebufferNew);
+    vm.addLocal(loc, "strBuilderNew", strBuilderNew);
     vm.addLocal(loc, "ok", resultNewOk);
     vm.addLocal(loc, "err", resultNewErr);
 
@@ -702,6 +805,7 @@ INIT_DLL(Prelude)
     vm.addTypeFn<VarStr>(loc, "_copy_", strCopy);
     vm.addTypeFn<VarVec>(loc, "_copy_", vecCopy);
     vm.addTypeFn<VarMap>(loc, "_copy_", mapCopy);
+    vm.addTypeFn<VarHashMap>(loc, "_copy_", hashMapCopy);
     vm.addTypeFn<VarStruct>(loc, "_copy_", structCopy);
     vm.addTypeFn<VarBytebuffer>(loc, "_copy_", bytebufferCopy);
 
@@ -714,6 +818,7 @@ INIT_DLL(Prelude)
     vm.addTypeFn<VarStr>(loc, "bool", strToBool);
     vm.addTypeFn<VarVec>(loc, "bool", vecToBool);
     vm.addTypeFn<VarMap>(loc, "bool", mapToBool);
+    vm.addTypeFn<VarHashMap>(loc, "bool", hashMapToBool);
     vm.addTypeFn<VarTypeID>(loc, "bool", typeIDToBool);
 
     // to int
@@ -887,6 +992,7 @@ INIT_DLL(Prelude)
     vm.addTypeFn<VarStr>(loc, "endsWith", strEndsWith);
     vm.addTypeFn<VarStr>(loc, "fit", strFit);
     vm.addTypeFn<VarStr>(loc, "fmt", strFormat);
+    vm.addTypeFn<VarStr>(loc, "compileFormat", strCompileFormat);
     vm.addTypeFn<VarStr>(loc, "getBinStrFromHexStr", hexStrToBinStr);
     vm.addTypeFn<VarStr>(loc, "getUTF8CharFromBinStr", utf8CharFromBinStr);
 
@@ -913,6 +1019,8 @@ INIT_DLL(Prelude)
     vm.addTypeFn<VarVec>(loc, "at", vecAt);
     vm.addTypeFn<VarVec>(loc, "[]", vecAt);
 
+    vm.addTypeFn<VarVec>(loc, "sort", vecSort);
+    vm.addTypeFn<VarVec>(loc, "stableSort", vecStableSort);
     vm.addTypeFn<VarVec>(loc, "subNative", vecSubNative);
     vm.addTypeFn<VarVec>(loc, "sliceNative", vecSliceNative);
 
@@ -935,6 +1043,21 @@ INIT_DLL(Prelude)
     vm.addTypeFn<VarMap>(loc, "each", mapEach);
     vm.addTypeFn<VarMapIterator>(loc, "next", mapIteratorNext);
 
+    // hash map
+
+    vm.addTypeFn<VarHashMap>(loc, "len", hashMapSize);
+    vm.addTypeFn<VarHashMap>(loc, "isRef", hashMapIsRef);
+    vm.addTypeFn<VarHashMap>(loc, "empty", hashMapEmpty);
+    vm.addTypeFn<VarHashMap>(loc, "insert", hashMapInsert);
+    vm.addTypeFn<VarHashMap>(loc, "erase", hashMapErase);
+    vm.addTypeFn<VarHashMap>(loc, "clear", hashMapClear);
+    vm.addTypeFn<VarHashMap>(loc, "find", hashMapFind);
+    vm.addTypeFn<VarHashMap>(loc, "at", hashMapAt);
+    vm.addTypeFn<VarHashMap>(loc, "[]", hashMapAt);
+
+    vm.addTypeFn<VarHashMap>(loc, "each", hashMapEach);
+    vm.addTypeFn<VarHashMapIterator>(loc, "next", hashMapIteratorNext);
+
     // struct
 
     vm.addTypeFn<VarStructDef>(loc, "setTypeName", structDefSetTypeName);
@@ -952,6 +1075,20 @@ INIT_DLL(Prelude)
     vm.addTypeFn<VarBytebuffer>(loc, "capacity", bytebufferCapacity);
     vm.addTypeFn<VarBytebuffer>(loc, "str", bytebufferToStr);
 
+    // string builder
+
+    vm.addTypeFn<VarStrBuilder>(loc, "append", strBuilderAppend);
+    vm.addTypeFn<VarStrBuilder>(loc, "appendLine", strBuilderAppendLine);
+    vm.addTypeFn<VarStrBuilder>(loc, "reserve", strBuilderReserve);
+    vm.addTypeFn<VarStrBuilder>(loc, "len", strBuilderLen);
+    vm.addTypeFn<VarStrBuilder>(loc, "clear", strBuilderClear);
+    vm.addTypeFn<VarStrBuilder>(loc, "build", strBuilderBuild);
+    vm.addTypeFn<VarStrBuilder>(loc, "str", strBuilderToStr);
+
+    // string template
+
+    vm.addTypeFn<VarStrTemplate>(loc, "render", strTemplateRender);
+
     // path
 
     vm.addTypeFn<VarPath>(loc, "_copy_", pathCopy);
@@ -0,0 +1,321 @@
+#include <algorithm>
+#include <charconv>
+
+#include "SIMD.hpp"
+#include "VM/VM.hpp"
+
+namespace fer
+{
+
+// Maps and arrays nested deeper than this are rejected, so that the recursive parser cannot
+// overflow the native stack.
+constexpr size_t MAX_FECL_DEPTH = 1024;
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////// Parser /////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Builds the Feral values (Map, Vec, Str, Int, Flt, Bool) directly from the FeCL text.
+// Like before, the strings are kept as they are written (escape sequences are not processed).
+// All the functions return nullptr (or false) after calling vm.fail() on invalid input.
+class FeCLParser
+{
+    VirtualMachine &vm;
+    ModuleLoc loc;
+    StringRef data;
+    size_t i;
+    size_t depth;
+
+    template<typename... Args> void fail(Args &&...args)
+    {
+        size_t line = std::count(data.begin(), data.begin() + std::min(i, data.size()), '\n');
+        vm.fail(loc, "invalid FeCL at line ", line + 1, ": ", std::forward<Args>(args)...);
+    }
+
+    // Skips the whitespace and comments, returns false at the end of data.
+    bool skip();
+    bool expect(char c);
+    // Parses the `key = value;` items until `end` (or end of data if `end` is 0).
+    bool parseItems(VarMap *res, char end);
+    Var *parseValue();
+    Var *parseVec();
+    Var *parseNum();
+    bool parseKey(StringRef &res);
+    bool parseStr(StringRef &res);
+    StringRef parseIden();
+
+public:
+    FeCLParser(VirtualMachine &vm, ModuleLoc loc, StringRef data);
+
+    Var *parse();
+};
+
+static inline bool isIdenStart(char c) { return isalpha(c) || c == '_'; }
+static inline bool isIdenChar(char c) { return isalnum(c) || c == '_' || c == '-'; }
+
+FeCLParser::FeCLParser(VirtualMachine &vm, ModuleLoc loc, StringRef data)
+    : vm(vm), loc(loc), data(data), i(0), depth(0)
+{}
+
+Var *FeCLParser::parse()
+{
+    VarMap *res = vm.makeVar<VarMap>(loc, false, false);
+    if(!parseItems(res, 0)) {
+        vm.decVarRef(res);
+        return nullptr;
+    }
+    return res;
+}
+
+bool FeCLParser::skip()
+{
+    while(true) {
+        i = simd::skipSpaces(data, i);
+        if(i >= data.size()) return false;
+        if(data[i] != '#') return true;
+        i = data.find('\n', i);
+        if(i == StringRef::npos) i = data.size();
+    }
+}
+
+bool FeCLParser::expect(char c)
+{
+    if(!skip()) {
+        fail("expected '", c, "', found end of data");
+        return false;
+    }
+    if(data[i] != c) {
+        fail("expected '", c, "', found: '", data[i], "'");
+        return false;
+    }
+    ++i;
+    return true;
+}
+
+bool FeCLParser::parseItems(VarMap *res, char end)
+{
+    while(true) {
+        if(!skip()) {
+            if(!end) return true;
+            fail("expected '", end, "', found end of data");
+            return false;
+        }
+        if(end && data[i] == end) {
+            ++i;
+            return true;
+        }
+        StringRef key;
+        if(!parseKey(key) || !expect('=')) return false;
+        Var *val = parseValue();
+        if(!val) return false;
+        res->setAttr(vm, key, val, true);
+        if(!expect(';')) return false;
+    }
+}
+
+Var *FeCLParser::parseValue()
+{
+    if(!skip()) {
+        fail("expected a value, found end of data");
+        return nullptr;
+    }
+    char c = data[i];
+    if(c == '{' || c == '[') {
+        if(++depth > MAX_FECL_DEPTH) {
+            fail("nesting depth exceeds ", MAX_FECL_DEPTH);
+            return nullptr;
+        }
+        ++i;
+        Var *res = nullptr;
+        if(c == '[') {
+            res = parseVec();
+        } else {
+            res = vm.makeVar<VarMap>(loc, false, false);
+            if(!parseItems(as<VarMap>(res), '}')) {
+                vm.decVarRef(res);
+                res = nullptr;
+            }
+        }
+        --depth;
+        return res;
+    }
+    if(c == '\'' || c == '"') {
+        StringRef s;
+        if(!parseStr(s)) return nullptr;
+        return vm.makeVar<VarStr>(loc, s);
+    }
+    if(c == '-' || isdigit(c)) return parseNum();
+    if(isIdenStart(c)) {
+        StringRef iden = parseIden();
+        if(iden == "true") return vm.getTrue();
+        if(iden == "false") return vm.getFalse();
+        i -= iden.size();
+        fail("invalid value: '", iden, "'");
+        return nullptr;
+    }
+    fail("invalid character: '", c, "'");
+    return nullptr;
+}
+
+Var *FeCLParser::parseVec()
+{
+    VarVec *res = vm.makeVar<VarVec>(loc, 0, false);
+    if(skip() && data[i] == ']') {
+        ++i;
+        return res;
+    }
+    while(true) {
+        Var *val = parseValue();
+        if(!val) goto fail;
+        res->push(vm, val, true);
+        if(skip() && data[i] == ',') {
+            ++i;
+            continue;
+        }
+        if(!expect(']')) goto fail;
+        break;
+    }
+    return res;
+fail:
+    vm.decVarRef(res);
+    return nullptr;
+}
+
+Var *FeCLParser::parseNum()
+{
+    size_t start = i;
+    bool isFlt   = false;
+    if(data[i] == '-') ++i;
+    size_t digits = i;
+    for(; i < data.size() && (isdigit(data[i]) || data[i] == '.'); ++i) {
+        if(data[i] != '.') continue;
+        if(isFlt) {
+            fail("multiple dots in a number");
+            return nullptr;
+        }
+        isFlt = true;
+    }
+    if(i == digits) {
+        fail("expected a number after '-'");
+        return nullptr;
+    }
+    StringRef num = data.substr(start, i - start);
+    if(!isFlt) {
+        int64_t intval;
+        auto res = std::from_chars(num.data(), num.data() + num.size(), intval);
+        if(res.ec != std::errc()) {
+            fail("invalid integer: ", num);
+            return nullptr;
+        }
+        return vm.makeVar<VarInt>(loc, intval);
+    }
+    // FIXME: from_chars() does not work with LLVM's libc++
+#if defined(_LIBCPP_VERSION)
+    String numtmp(num);
+    double fltval = std::strtod(numtmp.c_str(), nullptr);
+#else
+    double fltval = 0.0;
+    std::from_chars(num.data(), num.data() + num.size(), fltval);
+#endif
+    return vm.makeVar<VarFlt>(loc, fltval);
+}
+
+bool FeCLParser::parseKey(StringRef &res)
+{
+    if(data[i] == '\'' || data[i] == '"') return parseStr(res);
+    if(!isIdenStart(data[i])) {
+        fail("expected an identifier or a string as key, found: '", data[i], "'");
+        return false;
+    }
+    res = parseIden();
+    return true;
+}
+
+bool FeCLParser::parseStr(StringRef &res)
+{
+    char quote   = data[i];
+    size_t start = ++i;
+    while(true) {
+        i = simd::findAny(data, i, quote, '\\', quote);
+        if(i >= data.size()) {
+            i = start - 1;
+            fail("no end quotes for the string");
+            return false;
+        }
+        if(data[i] == quote) break;
+        i += 2; // the escaped char
+    }
+    res = data.substr(start, i - start);
+    ++i;
+    return true;
+}
+
+StringRef FeCLParser::parseIden()
+{
+    size_t start = i;
+    while(i < data.size() && isIdenChar(data[i])) ++i;
+    return data.substr(start, i - start);
+}
+
+// Deep copies the values created by the parser, much faster than calling their _copy_()
+// functions. Used for returning the cached configs.
+static Var *cloneValue(VirtualMachine &vm, ModuleLoc loc, Var *var)
+{
+    if(var->is<VarMap>()) {
+        VarMap *src = as<VarMap>(var);
+        VarMap *res = vm.makeVar<VarMap>(loc, false, false);
+        res->reserve(src->size());
+        for(auto &e : src->getVal()) res->setAttr(vm, e.first, cloneValue(vm, loc, e.second), true);
+        return res;
+    }
+    if(var->is<VarVec>()) {
+        VarVec *src = as<VarVec>(var);
+        VarVec *res = vm.makeVar<VarVec>(loc, src->size(), false);
+        for(auto &e : src->getVal()) res->push(vm, cloneValue(vm, loc, e), true);
+        return res;
+    }
+    if(var->is<VarStr>()) return vm.makeVar<VarStr>(loc, as<VarStr>(var));
+    if(var->is<VarInt>()) return vm.makeVar<VarInt>(loc, as<VarInt>(var)->getVal());
+    if(var->is<VarFlt>()) return vm.makeVar<VarFlt>(loc, as<VarFlt>(var)->getVal());
+    // Bools are the VM's singletons
+    return var;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+/////////////////////////////////////////// Functions ////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+FERAL_FUNC(loadsNative, 1, false,
+           "  fn(data) -> Map\n"
+           "Parses the FeCL string `data` and returns the equivalent Feral map.")
+{
+    EXPECT(VarStr, args[1], "FeCL data");
+    FeCLParser parser(vm, loc, as<VarStr>(args[1])->getView());
+    return parser.parse();
+}
+
+FERAL_FUNC(contentHash, 1, false,
+           "  fn(data) -> Int\n"
+           "Returns a (non cryptographic) hash of the string `data`.")
+{
+    EXPECT(VarStr, args[1], "data");
+    size_t hash = std::hash<StringRef>{}(as<VarStr>(args[1])->getView());
+    return vm.makeVar<VarInt>(loc, (int64_t)hash);
+}
+
+FERAL_FUNC(cloneNative, 1, false,
+           "  fn(obj) -> Var\n"
+           "Returns a deep copy of `obj`, which must be an object created by loadsNative().")
+{
+    return cloneValue(vm, loc, args[1]);
+}
+
+INIT_DLL(FECL)
+{
+    vm.addLocal(loc, "loadsNative", loadsNative);
+    vm.addLocal(loc, "contentHash", contentHash);
+    vm.addLocal(loc, "cloneNative", cloneNative);
+    return true;
+}
+
+} // namespace fer
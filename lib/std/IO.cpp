@@ -22,14 +22,14 @@ ssize_t printBase(VirtualMachine &vm, ModuleLoc loc, FILE *file, Span<Var *> arg
     ssize_t count = 0;
     for(auto &a : args) {
         if(a->is<VarStr>()) {
-            const String &s = as<VarStr>(a)->getVal();
+            StringRef s = as<VarStr>(a)->getView();
             count += writeToFile(file, s);
             continue;
         }
         Var *v = nullptr;
         Array<Var *, 1> tmp{a};
         if(!vm.callVarAndExpect<VarStr>(loc, "str", v, tmp, {})) return -1;
-        const String &s = as<VarStr>(v)->getVal();
+        StringRef s = as<VarStr>(v)->getView();
         count += writeToFile(file, s);
         vm.decVarRef(v);
     }
@@ -0,0 +1,752 @@
+#include "JSON.hpp"
+
+#include <charconv>
+#include <cmath>
+
+#include "SIMD.hpp"
+#include "VM/VM.hpp"
+
+namespace fer
+{
+
+// Objects and arrays nested deeper than this are rejected, so that the recursive parser and writer
+// cannot overflow the native stack.
+constexpr size_t MAX_JSON_DEPTH = 1024;
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////// Parser /////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Builds the Feral values (Map, Vec, Str, Int, Flt, Bool, Nil) directly from the JSON text.
+// All the functions return nullptr (or false) after calling vm.fail() on invalid input.
+// The values are returned with a counted reference, which the caller owns - keywords return the
+// VM's true/false/nil vars, so those must never be released without having been counted.
+class JSONParser
+{
+    VirtualMachine &vm;
+    ModuleLoc loc;
+    StringRef data;
+    size_t i;
+    size_t depth;
+
+    template<typename... Args> void fail(Args &&...args)
+    {
+        vm.fail(loc, "invalid json at offset ", i, ": ", std::forward<Args>(args)...);
+    }
+
+    Var *parseValue();
+    Var *parseMap();
+    Var *parseVec();
+    Var *parseNum();
+    Var *parseKeyword(StringRef word, Var *res);
+    bool parseStr(String &res);
+    bool parseEscape(String &res);
+    bool parseHex4(uint32_t &res);
+
+public:
+    JSONParser(VirtualMachine &vm, ModuleLoc loc, StringRef data);
+
+    Var *parse();
+};
+
+JSONParser::JSONParser(VirtualMachine &vm, ModuleLoc loc, StringRef data)
+    : vm(vm), loc(loc), data(data), i(0), depth(0)
+{}
+
+Var *JSONParser::parse()
+{
+    Var *res = parseValue();
+    if(!res) return nullptr;
+    i = simd::skipSpaces(data, i);
+    if(i < data.size()) {
+        fail("unexpected data after the value: '", data[i], "'");
+        vm.decVarRef(res);
+        return nullptr;
+    }
+    // the caller (VM) takes its own reference
+    return vm.decVarRef(res, false);
+}
+
+Var *JSONParser::parseValue()
+{
+    i = simd::skipSpaces(data, i);
+    if(i >= data.size()) {
+        fail("expected a value, found end of data");
+        return nullptr;
+    }
+    switch(data[i]) {
+    case '{': return parseMap();
+    case '[': return parseVec();
+    case '"': {
+        String s;
+        if(!parseStr(s)) return nullptr;
+        return vm.incVarRef(vm.makeVar<VarStr>(loc, std::move(s)));
+    }
+    case 't': return parseKeyword("true", vm.getTrue());
+    case 'f': return parseKeyword("false", vm.getFalse());
+    case 'n': return parseKeyword("null", vm.getNil());
+    default: break;
+    }
+    if(data[i] == '-' || isdigit(data[i])) return parseNum();
+    fail("unexpected character: '", data[i], "'");
+    return nullptr;
+}
+
+Var *JSONParser::parseMap()
+{
+    if(++depth > MAX_JSON_DEPTH) {
+        fail("nesting depth exceeds ", MAX_JSON_DEPTH);
+        return nullptr;
+    }
+    ++i; // {
+    VarMap *res = vm.incVarRef(vm.makeVar<VarMap>(loc, false, false));
+    i           = simd::skipSpaces(data, i);
+    if(i < data.size() && data[i] == '}') {
+        ++i;
+        --depth;
+        return res;
+    }
+    String key;
+    while(true) {
+        i = simd::skipSpaces(data, i);
+        if(i >= data.size() || data[i] != '"') {
+            fail("expected a string key in object");
+            goto fail;
+        }
+        key.clear();
+        if(!parseStr(key)) goto fail;
+        i = simd::skipSpaces(data, i);
+        if(i >= data.size() || data[i] != ':') {
+            fail("expected ':' after the object key");
+            goto fail;
+        }
+        ++i;
+        Var *val = parseValue();
+        if(!val) goto fail;
+        res->setAttr(vm, key, val, false);
+        i = simd::skipSpaces(data, i);
+        if(i < data.size() && data[i] == ',') {
+            ++i;
+            continue;
+        }
+        if(i < data.size() && data[i] == '}') break;
+        fail("expected ',' or '}' in object");
+        goto fail;
+    }
+    ++i;
+    --depth;
+    return res;
+fail:
+    vm.decVarRef(res);
+    return nullptr;
+}
+
+Var *JSONParser::parseVec()
+{
+    if(++depth > MAX_JSON_DEPTH) {
+        fail("nesting depth exceeds ", MAX_JSON_DEPTH);
+        return nullptr;
+    }
+    ++i; // [
+    VarVec *res = vm.incVarRef(vm.makeVar<VarVec>(loc, 0, false));
+    i           = simd::skipSpaces(data, i);
+    if(i < data.size() && data[i] == ']') {
+        ++i;
+        --depth;
+        return res;
+    }
+    while(true) {
+        Var *val = parseValue();
+        if(!val) goto fail;
+        res->push(vm, val, false);
+        i = simd::skipSpaces(data, i);
+        if(i < data.size() && data[i] == ',') {
+            ++i;
+            continue;
+        }
+        if(i < data.size() && data[i] == ']') break;
+        fail("expected ',' or ']' in array");
+        goto fail;
+    }
+    ++i;
+    --depth;
+    return res;
+fail:
+    vm.decVarRef(res);
+    return nullptr;
+}
+
+Var *JSONParser::parseNum()
+{
+    size_t start = i;
+    bool isFlt   = false;
+    size_t len   = data.size();
+    if(data[i] == '-') ++i;
+    if(i >= len || !isdigit(data[i])) {
+        fail("expected a digit in number");
+        return nullptr;
+    }
+    while(i < len && isdigit(data[i])) ++i;
+    if(i < len && data[i] == '.') {
+        isFlt = true;
+        ++i;
+        if(i >= len || !isdigit(data[i])) {
+            fail("expected a digit after the decimal point");
+            return nullptr;
+        }
+        while(i < len && isdigit(data[i])) ++i;
+    }
+    if(i < len && (data[i] == 'e' || data[i] == 'E')) {
+        isFlt = true;
+        ++i;
+        if(i < len && (data[i] == '+' || data[i] == '-')) ++i;
+        if(i >= len || !isdigit(data[i])) {
+            fail("expected a digit in the exponent");
+            return nullptr;
+        }
+        while(i < len && isdigit(data[i])) ++i;
+    }
+    StringRef num = data.substr(start, i - start);
+    if(!isFlt) {
+        int64_t intval;
+        auto res = std::from_chars(num.data(), num.data() + num.size(), intval);
+        if(res.ec == std::errc()) return vm.incVarRef(vm.makeVar<VarInt>(loc, intval));
+        // too large for an Int, so it is stored as a Flt
+    }
+    // FIXME: from_chars() does not work with LLVM's libc++
+#if defined(_LIBCPP_VERSION)
+    String numtmp(num);
+    double fltval = std::strtod(numtmp.c_str(), nullptr);
+#else
+    double fltval;
+    auto res = std::from_chars(num.data(), num.data() + num.size(), fltval);
+    if(res.ec == std::errc::result_out_of_range) {
+        // overflows to infinity, and underflows to zero
+        String numtmp(num);
+        fltval = std::strtod(numtmp.c_str(), nullptr);
+    }
+#endif
+    return vm.incVarRef(vm.makeVar<VarFlt>(loc, fltval));
+}
+
+Var *JSONParser::parseKeyword(StringRef word, Var *res)
+{
+    if(data.substr(i, word.size()) != word) {
+        fail("unknown keyword, expected '", word, "'");
+        return nullptr;
+    }
+    i += word.size();
+    return vm.incVarRef(res);
+}
+
+bool JSONParser::parseStr(String &res)
+{
+    ++i; // "
+    while(true) {
+        size_t end = simd::findAny(data, i, '"', '\\', '"');
+        res.append(data.substr(i, end - i));
+        i = end;
+        if(i >= data.size()) {
+            fail("no end quotes for the string");
+            return false;
+        }
+        if(data[i] == '"') break;
+        if(!parseEscape(res)) return false;
+    }
+    ++i;
+    return true;
+}
+
+bool JSONParser::parseEscape(String &res)
+{
+    ++i; // backslash
+    if(i >= data.size()) {
+        fail("incomplete escape sequence");
+        return false;
+    }
+    switch(data[i++]) {
+    case '"': res += '"'; return true;
+    case '\\': res += '\\'; return true;
+    case '/': res += '/'; return true;
+    case 'b': res += '\b'; return true;
+    case 'f': res += '\f'; return true;
+    case 'n': res += '\n'; return true;
+    case 'r': res += '\r'; return true;
+    case 't': res += '\t'; return true;
+    case 'u': break;
+    default: --i; fail("invalid escape sequence: '\\", data[i], "'"); return false;
+    }
+    uint32_t cp;
+    if(!parseHex4(cp)) return false;
+    if(cp >= 0xD800 && cp <= 0xDBFF) {
+        // high surrogate, must be followed by a low one
+        uint32_t low;
+        if(data.substr(i, 2) != "\\u") {
+            fail("expected a low surrogate after the high surrogate");
+            return false;
+        }
+        i += 2;
+        if(!parseHex4(low)) return false;
+        if(low < 0xDC00 || low > 0xDFFF) {
+            fail("invalid low surrogate");
+            return false;
+        }
+        cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+    } else if(cp >= 0xDC00 && cp <= 0xDFFF) {
+        fail("unexpected low surrogate");
+        return false;
+    }
+    // encode as UTF-8
+    if(cp < 0x80) {
+        res += (char)cp;
+    } else if(cp < 0x800) {
+        res += (char)(0xC0 | (cp >> 6));
+        res += (char)(0x80 | (cp & 0x3F));
+    } else if(cp < 0x10000) {
+        res += (char)(0xE0 | (cp >> 12));
+        res += (char)(0x80 | ((cp >> 6) & 0x3F));
+        res += (char)(0x80 | (cp & 0x3F));
+    } else {
+        res += (char)(0xF0 | (cp >> 18));
+        res += (char)(0x80 | ((cp >> 12) & 0x3F));
+        res += (char)(0x80 | ((cp >> 6) & 0x3F));
+        res += (char)(0x80 | (cp & 0x3F));
+    }
+    return true;
+}
+
+bool JSONParser::parseHex4(uint32_t &res)
+{
+    if(i + 4 > data.size()) {
+        fail("incomplete unicode escape sequence");
+        return false;
+    }
+    auto conv = std::from_chars(data.data() + i, data.data() + i + 4, res, 16);
+    if(conv.ec != std::errc() || conv.ptr != data.data() + i + 4) {
+        fail("invalid unicode escape sequence");
+        return false;
+    }
+    i += 4;
+    return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////// Writer /////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Serializes a value into a single output string.
+// `level` is -1 for the single line output, otherwise it is the nesting level of the value, and
+// each nested item is written on a new line, indented with `indentChar` (level + 1) times.
+class JSONWriter
+{
+    VirtualMachine &vm;
+    ModuleLoc loc;
+    StringRef indentChar;
+    String &out;
+    size_t depth;
+
+    void writeIndent(int level);
+    void writeStr(StringRef s);
+    bool writeCustom(Var *var, int level);
+
+public:
+    JSONWriter(VirtualMachine &vm, ModuleLoc loc, StringRef indentChar, String &out);
+
+    bool write(Var *var, int level);
+};
+
+JSONWriter::JSONWriter(VirtualMachine &vm, ModuleLoc loc, StringRef indentChar, String &out)
+    : vm(vm), loc(loc), indentChar(indentChar), out(out), depth(0)
+{}
+
+bool JSONWriter::write(Var *var, int level)
+{
+    if(var->is<VarNil>()) {
+        out += "null";
+    } else if(var->is<VarBool>()) {
+        out += as<VarBool>(var)->getVal() ? "true" : "false";
+    } else if(var->is<VarInt>()) {
+        char buf[24];
+        auto res = std::to_chars(buf, buf + sizeof(buf), as<VarInt>(var)->getVal());
+        out.append(buf, res.ptr);
+    } else if(var->is<VarFlt>()) {
+        double val = as<VarFlt>(var)->getVal();
+        if(!std::isfinite(val)) {
+            vm.fail(loc, "cannot serialize a non finite float to JSON: ", val);
+            return false;
+        }
+        out += std::to_string(val);
+    } else if(var->is<VarStr>()) {
+        writeStr(as<VarStr>(var)->getView());
+    } else if(var->is<VarVec>() || var->is<VarMap>()) {
+        if(++depth > MAX_JSON_DEPTH) {
+            vm.fail(loc, "nesting depth exceeds ", MAX_JSON_DEPTH, " in JSON serialization");
+            return false;
+        }
+        bool isMap = var->is<VarMap>();
+        int inner  = level < 0 ? level : level + 1;
+        bool first = true;
+        out += isMap ? '{' : '[';
+        auto writeSep = [&]() {
+            if(!first) out += level < 0 ? ", " : ",";
+            first = false;
+            writeIndent(inner);
+        };
+        if(isMap) {
+            VarMap *m = as<VarMap>(var);
+            for(auto it = m->begin(); it != m->end(); m->next(it)) {
+                writeSep();
+                writeStr(it.key());
+                out += ": ";
+                if(!write(it.val(), inner)) return false;
+            }
+        } else {
+            for(auto &e : as<VarVec>(var)->getVal()) {
+                writeSep();
+                if(!write(e, inner)) return false;
+            }
+        }
+        if(!first) writeIndent(level);
+        out += isMap ? '}' : ']';
+        --depth;
+    } else {
+        return writeCustom(var, level);
+    }
+    return true;
+}
+
+void JSONWriter::writeIndent(int level)
+{
+    if(level < 0) return;
+    out += '\n';
+    for(int i = 0; i < level; ++i) out += indentChar;
+}
+
+void JSONWriter::writeStr(StringRef s)
+{
+    static constexpr char hex[] = "0123456789abcdef";
+    out += '"';
+    size_t i = 0, len = s.size();
+    while(i < len) {
+        // copy the runs which need no escaping as a whole
+        size_t start = i;
+#if defined(__AVX2__) || defined(__SSE2__)
+        for(; i + simd::WIDTH <= len; i += simd::WIDTH) {
+            simd::Vec v    = simd::load(&s[i]);
+            simd::Vec quot = simd::bor(simd::eq(v, simd::set1('"')), simd::eq(v, simd::set1('\\')));
+            simd::Mask m   = simd::mask(simd::bor(quot, simd::inRange(v, 0, 0x1F)));
+            if(m) {
+                i += std::countr_zero(m);
+                break;
+            }
+        }
+#endif
+        while(i < len && s[i] != '"' && s[i] != '\\' && (unsigned char)s[i] >= 0x20) ++i;
+        out.append(s.substr(start, i - start));
+        if(i >= len) break;
+        char c = s[i++];
+        out += '\\';
+        switch(c) {
+        case '"': out += '"'; break;
+        case '\\': out += '\\'; break;
+        case '\b': out += 'b'; break;
+        case '\f': out += 'f'; break;
+        case '\n': out += 'n'; break;
+        case '\r': out += 'r'; break;
+        case '\t': out += 't'; break;
+        default:
+            out += "u00";
+            out += hex[(c >> 4) & 0xF];
+            out += hex[c & 0xF];
+            break;
+        }
+    }
+    out += '"';
+}
+
+bool JSONWriter::writeCustom(Var *var, int level)
+{
+    // the other types must implement `jsonToStr(indent, indentChar)`
+    Var *fn  = vm.getTypeFn(var, "jsonToStr");
+    Var *res = nullptr;
+    if(fn) {
+        VarInt *indentVar = vm.makeVar<VarInt>(loc, level);
+        VarStr *charVar   = vm.makeVar<VarStr>(loc, indentChar);
+        vm.incVarRef(indentVar);
+        vm.incVarRef(charVar);
+        Array<Var *, 3> args{var, indentVar, charVar};
+        bool ok = vm.callVarAndExpect<VarStr>(loc, "jsonToStr", fn, res, args, nullptr);
+        vm.decVarRef(indentVar);
+        vm.decVarRef(charVar);
+        if(!ok) return false;
+    }
+    if(!res || as<VarStr>(res)->getView().empty()) {
+        vm.fail(loc, "type ", vm.getTypeName(var), " does not implement JSON serialization");
+        if(res) vm.decVarRef(res);
+        return false;
+    }
+    out += as<VarStr>(res)->getView();
+    vm.decVarRef(res);
+    return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////// Reader /////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+// The chars which end a number or a keyword
+static inline bool isScalarEnd(char c)
+{
+    return isspace(c) || c == ',' || c == ':' || c == '[' || c == ']' || c == '{' || c == '}' ||
+           c == '"';
+}
+
+VarJSONReader::VarJSONReader(ModuleLoc loc)
+    : Var(loc), start(0), scanPos(0), valEnd(0), depth(0), kind(0), inStr(false), finished(false),
+      value(nullptr)
+{}
+
+void VarJSONReader::onDestroy(VirtualMachine &vm)
+{
+    if(value) vm.decVarRef(value);
+}
+
+bool VarJSONReader::onSet(VirtualMachine &vm, Var *from)
+{
+    VarJSONReader *other = as<VarJSONReader>(from);
+    buf                  = other->buf;
+    start                = other->start;
+    scanPos              = other->scanPos;
+    valEnd               = other->valEnd;
+    depth                = other->depth;
+    kind                 = other->kind;
+    inStr                = other->inStr;
+    finished             = other->finished;
+    setValue(vm, other->value ? vm.incVarRef(other->value) : nullptr);
+    return true;
+}
+
+void VarJSONReader::setValue(VirtualMachine &vm, Var *val)
+{
+    if(value) vm.decVarRef(value);
+    value = val;
+}
+
+void VarJSONReader::feed(StringRef data)
+{
+    compact();
+    buf.append(data);
+}
+
+bool VarJSONReader::scan()
+{
+    if(valEnd) return true;
+    if(!kind) {
+        scanPos = simd::skipSpaces(buf, scanPos);
+        start   = scanPos;
+        if(scanPos >= buf.size()) return false;
+        kind = buf[scanPos];
+        switch(kind) {
+        case '{':
+        case '[': depth = 1; ++scanPos; break;
+        case '"': inStr = true; ++scanPos; break;
+        case '}':
+        case ']':
+        case ',':
+        case ':':
+            // not the beginning of a value - left for the parser to report
+            valEnd = ++scanPos;
+            return true;
+        default: return scanScalar();
+        }
+    }
+    return kind == '{' || kind == '[' || kind == '"' ? scanContainer() : scanScalar();
+}
+
+bool VarJSONReader::scanContainer()
+{
+    size_t len = buf.size();
+    while(scanPos < len) {
+        if(inStr) {
+            size_t end = simd::findAny(buf, scanPos, '"', '\\', '"');
+            if(end >= len) {
+                scanPos = len;
+                return false;
+            }
+            if(buf[end] == '\\') {
+                // the escaped char may not have arrived yet
+                if(end + 1 >= len) {
+                    scanPos = end;
+                    return false;
+                }
+                scanPos = end + 2;
+                continue;
+            }
+            inStr   = false;
+            scanPos = end + 1;
+            if(depth == 0) break;
+            continue;
+        }
+        char c = buf[scanPos++];
+        if(c == '"') inStr = true;
+        else if(c == '{' || c == '[') ++depth;
+        else if((c == '}' || c == ']') && --depth == 0) break;
+    }
+    if(inStr || depth > 0) return false;
+    valEnd = scanPos;
+    return true;
+}
+
+bool VarJSONReader::scanScalar()
+{
+    size_t len = buf.size();
+    while(scanPos < len && !isScalarEnd(buf[scanPos])) ++scanPos;
+    // more digits may still arrive
+    if(scanPos >= len && !finished) return false;
+    valEnd = scanPos;
+    return true;
+}
+
+StringRef VarJSONReader::take()
+{
+    StringRef res = StringRef(buf).substr(start, valEnd - start);
+    start = scanPos = valEnd;
+    valEnd          = 0;
+    depth           = 0;
+    kind            = 0;
+    inStr           = false;
+    return res;
+}
+
+void VarJSONReader::compact()
+{
+    if(start == 0 || start < buf.size() / 2) return;
+    buf.erase(0, start);
+    scanPos -= start;
+    // the value may already be scanned (by ready()) but not taken yet
+    if(valEnd) valEnd -= start;
+    start = 0;
+}
+
+bool VarJSONReader::isTruncated() { return finished && !scan() && kind; }
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+/////////////////////////////////////////// Functions ////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+FERAL_FUNC(loadsNative, 1, false,
+           "  fn(data) -> Var\n"
+           "Parses the JSON string `data` and returns the equivalent Feral value.")
+{
+    EXPECT(VarStr, args[1], "json data");
+    JSONParser parser(vm, loc, as<VarStr>(args[1])->getView());
+    return parser.parse();
+}
+
+FERAL_FUNC(dumpsNative, 3, false,
+           "  fn(obj, indent, indentChar) -> Str\n"
+           "Serializes `obj` to a JSON string. If `indent` is -1, the result is a single line, "
+           "otherwise the nested items are written on separate lines, indented using "
+           "`indentChar`, starting at the level `indent`.")
+{
+    EXPECT(VarInt, args[2], "indentation level");
+    EXPECT(VarStr, args[3], "indentation char");
+    String out;
+    int level = std::max(as<VarInt>(args[2])->getVal(), (int64_t)-1);
+    JSONWriter writer(vm, loc, as<VarStr>(args[3])->getView(), out);
+    if(!writer.write(args[1], level)) return nullptr;
+    return vm.makeVar<VarStr>(loc, std::move(out));
+}
+
+FERAL_FUNC(newReader, 0, false,
+           "  fn() -> JSONReader\n"
+           "Creates and returns a JSONReader, which parses the JSON values fed to it in chunks as "
+           "soon as each of them is complete.")
+{
+    return vm.makeVar<VarJSONReader>(loc);
+}
+
+FERAL_FUNC(readerFeed, 1, false,
+           "  var.fn(data) -> Nil\n"
+           "Appends the string or bytebuffer `data` to the input of the JSONReader `var`.")
+{
+    EXPECT2(VarStr, VarBytebuffer, args[1], "json data");
+    VarJSONReader *reader = as<VarJSONReader>(args[0]);
+    if(reader->isFinished()) {
+        vm.fail(loc, "cannot feed data to a finished JSONReader");
+        return nullptr;
+    }
+    if(args[1]->is<VarStr>()) {
+        reader->feed(as<VarStr>(args[1])->getView());
+    } else {
+        VarBytebuffer *bb = as<VarBytebuffer>(args[1]);
+        reader->feed(StringRef((const char *)bb->getVal(), bb->size()));
+    }
+    return vm.getNil();
+}
+
+FERAL_FUNC(readerFinish, 0, false,
+           "  var.fn() -> Nil\n"
+           "Marks the end of the input of the JSONReader `var`, so that a trailing number or "
+           "keyword is considered complete.")
+{
+    as<VarJSONReader>(args[0])->finish();
+    return vm.getNil();
+}
+
+FERAL_FUNC(readerReady, 0, false,
+           "  var.fn() -> Bool\n"
+           "Returns `true` if the JSONReader `var` has a complete value to be returned by next().")
+{
+    return as<VarJSONReader>(args[0])->scan() ? vm.getTrue() : vm.getFalse();
+}
+
+FERAL_FUNC(readerNext, 0, false,
+           "  var.fn() -> Bool | Nil\n"
+           "Parses the next complete value in the JSONReader `var`, which is then returned by "
+           "value(). Returns `true` if there was one, or `nil` if there is none yet.\n"
+           "This allows using the reader in a for-in loop, even with JSON `null` values.")
+{
+    VarJSONReader *reader = as<VarJSONReader>(args[0]);
+    if(!reader->scan()) {
+        if(reader->isTruncated()) {
+            vm.fail(loc, "invalid json: unexpected end of input");
+            return nullptr;
+        }
+        return vm.getNil();
+    }
+    JSONParser parser(vm, loc, reader->take());
+    Var *res = parser.parse();
+    reader->compact();
+    if(!res) return nullptr;
+    reader->setValue(vm, vm.incVarRef(res));
+    return vm.getTrue();
+}
+
+FERAL_FUNC(readerValue, 0, false,
+           "  var.fn() -> Var\n"
+           "Returns the value parsed by the last next() call of the JSONReader `var`, or `nil` if "
+           "there is none.")
+{
+    Var *res = as<VarJSONReader>(args[0])->getValue();
+    return res ? res : vm.getNil();
+}
+
+INIT_DLL(JSON)
+{
+    vm.addLocalType<VarJSONReader>(loc, "JSONReader",
+                                   "An incremental reader for a stream of JSON values.");
+
+    vm.addLocal(loc, "loadsNative", loadsNative);
+    vm.addLocal(loc, "dumpsNative", dumpsNative);
+    vm.addLocal(loc, "newReader", newReader);
+
+    vm.addTypeFn<VarJSONReader>(loc, "feed", readerFeed);
+    vm.addTypeFn<VarJSONReader>(loc, "finish", readerFinish);
+    vm.addTypeFn<VarJSONReader>(loc, "ready", readerReady);
+    vm.addTypeFn<VarJSONReader>(loc, "next", readerNext);
+    vm.addTypeFn<VarJSONReader>(loc, "value", readerValue);
+    return true;
+}
+
+} // namespace fer
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "VM/VarTypes.hpp"
+
+namespace fer
+{
+
+// Incremental reader for a stream of JSON values (like newline delimited JSON or a document
+// arriving in pieces from a socket).
+// Only the data of the values which are not consumed yet is kept, so the memory used is bounded
+// by the largest single value (plus the last fed chunk), not the size of the stream.
+class VarJSONReader : public Var
+{
+    String buf;
+    size_t start;   // beginning of the current value
+    size_t scanPos; // the data before this has already been scanned
+    size_t valEnd;  // end of the current value if it is complete, 0 otherwise
+    size_t depth;   // nesting depth of the current object / array
+    char kind;      // first char of the current value, 0 if it has not begun yet
+    bool inStr;
+    bool finished;
+    Var *value; // the last value returned by next(), nullptr if there is none
+
+    void onDestroy(VirtualMachine &vm) override;
+    bool onSet(VirtualMachine &vm, Var *from) override;
+
+    bool scanContainer();
+    bool scanScalar();
+
+public:
+    VarJSONReader(ModuleLoc loc);
+
+    void feed(StringRef data);
+    // Returns true if the current value is complete.
+    bool scan();
+    // Returns the current (complete) value, and marks it consumed.
+    StringRef take();
+    // Drops the consumed data, once it makes up at least half of the buffer.
+    void compact();
+    // Returns true if all the input is fed but it ends in an incomplete value.
+    bool isTruncated();
+
+    // Sets the value returned by next(), taking over the reference to it.
+    void setValue(VirtualMachine &vm, Var *val);
+
+    inline void finish() { finished = true; }
+    inline bool isFinished() { return finished; }
+    inline Var *getValue() { return value; }
+};
+
+} // namespace fer
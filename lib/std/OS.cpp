@@ -85,7 +85,7 @@ FERAL_FUNC(
         Var *v = nullptr;
         Array<Var *, 1> tmp{argsToUse[i]};
         if(!vm.callVarAndExpect<VarStr>(loc, "str", v, tmp, {})) return nullptr;
-        StringRef s        = as<VarStr>(v)->getVal();
+        StringRef s        = as<VarStr>(v)->getView();
         bool isArgOperator = !s.empty() && s[0] == '^';
         if(isArgOperator) s = s.substr(1);
         if(!isArgOperator) cmd += "\"";
@@ -59,7 +59,7 @@ FERAL_FUNC(regexMatch, 3, false,
     EXPECT(VarStr, args[1], "regex target");
     EXPECT3(VarStr, VarVec, VarNil, args[2], "capture destination");
     EXPECT(VarBool, args[3], "ignore first match");
-    StringRef target = as<VarStr>(args[1])->getVal();
+    StringRef target = as<VarStr>(args[1])->getView();
     Var *matches     = nullptr;
     if(args[2]->is<VarVec>() || args[2]->is<VarStr>()) matches = args[2];
     bool ignoreMatch = as<VarBool>(args[3])->getVal();
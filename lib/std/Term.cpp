@@ -122,7 +122,7 @@ FERAL_FUNC(getANSISeq, 1, false,
            "- bw: bright white color")
 {
     EXPECT(VarStr, args[1], "code");
-    StringRef code = as<VarStr>(args[1])->getVal();
+    StringRef code = as<VarStr>(args[1])->getView();
 
     auto colonPos = code.find(':');
     if(colonPos != StringRef::npos) {
@@ -18,13 +18,14 @@ namespace fer
 static Atomic<size_t> totalAllocRequests = 0, totalAllocBytes = 0, totalPoolAlloc = 0,
                       chunkReuseCount = 0;
 
-MemoryManager::MemoryManager(StringRef name, size_t poolSize)
-    : freechunks({}), name(name), poolSize(poolSize)
+MemoryManager::MemoryManager(StringRef name, size_t poolSize, bool withStats)
+    : freechunks({}), name(name), poolSize(poolSize), withStats(withStats), freeChunkBytes(0)
 {
     allocPool();
 }
 MemoryManager::~MemoryManager()
 {
+    setStatsDumpInterval(0);
     // clear out the allocations that are larger than MAX_ROUNDUP
     for(auto &sz : freechunks) {
         if(sz == 0) continue;
@@ -44,6 +45,11 @@ MemoryManager::~MemoryManager()
     LOG_INFO("--                         Chunk Reuse count: ", chunkReuseCount.load());
 }
 
+size_t MemoryManager::getTotalAllocRequests() { return totalAllocRequests; }
+size_t MemoryManager::getTotalAllocBytes() { return totalAllocBytes; }
+size_t MemoryManager::getTotalPoolAlloc() { return totalPoolAlloc; }
+size_t MemoryManager::getChunkReuseCount() { return chunkReuseCount; }
+
 size_t MemoryManager::nextPow2(size_t sz)
 {
     if(sz > MAX_ROUNDUP) return sz;
@@ -79,6 +85,11 @@ void *MemoryManager::allocRaw(size_t size, size_t align)
     char *loc = nullptr;
 
     ++totalAllocRequests;
+    if(withStats) {
+        AllocCounter &counter = sizeClassStats[getSizeClass(allocSz)];
+        ++counter.allocs;
+        counter.liveBytes += allocSz;
+    }
     if(allocSz > poolSize) {
         totalAllocBytes += allocSz;
         loc = (char *)AlignedAlloc(MAX_ALIGNMENT, allocSz);
@@ -94,6 +105,7 @@ void *MemoryManager::allocRaw(size_t size, size_t align)
             setAllocDetail(addrSz, AllocDetails::NEXT, 0);
             addrSz = nextTmp;
             ++chunkReuseCount;
+            freeChunkBytes -= allocSz;
             LOG_TRACE("Allocated ", allocSz, " using chunk list");
             // No need to size size bytes here because they would have already been set
             // when they were taken from the pool.
@@ -101,7 +113,9 @@ void *MemoryManager::allocRaw(size_t size, size_t align)
         }
 
         // fetch a chunk from the pool
-        for(auto &p : pools) {
+        size_t first = pools.size() > POOL_SCAN_COUNT ? pools.size() - POOL_SCAN_COUNT : 0;
+        for(size_t i = first; i < pools.size(); ++i) {
+            MemPool &p       = pools[i];
             size_t freespace = poolSize - (p.head - p.mem);
             if(freespace >= allocSz) {
                 loc = p.head;
@@ -129,6 +143,11 @@ void MemoryManager::freeRaw(void *data)
     if(data == nullptr) return;
     char *loc = (char *)data;
     size_t sz = getAllocDetail((size_t)loc, AllocDetails::SIZE);
+    if(withStats) {
+        AllocCounter &counter = sizeClassStats[getSizeClass(sz)];
+        ++counter.frees;
+        counter.liveBytes -= sz;
+    }
     if(sz > poolSize) {
         AlignedFree(loc - ALLOC_DETAIL_BYTES);
         return;
@@ -138,6 +157,116 @@ void MemoryManager::freeRaw(void *data)
     size_t &addrSz = freechunks[idx];
     setAllocDetail((size_t)loc, AllocDetails::NEXT, addrSz);
     addrSz = (size_t)loc;
+    freeChunkBytes += sz;
+}
+
+size_t MemoryManager::getSizeClass(size_t allocSz)
+{
+    if(allocSz > poolSize) return SIZE_CLASS_COUNT - 1;
+    if(allocSz > MAX_ROUNDUP) return SIZE_CLASS_COUNT - 2;
+    return getFreeChunkIndex(allocSz);
+}
+
+size_t MemoryManager::getSizeClassLimit(size_t sizeClass)
+{
+    if(sizeClass >= SIZE_CLASS_COUNT - 1) return 0;
+    if(sizeClass == SIZE_CLASS_COUNT - 2) return poolSize;
+    return (size_t)1 << (sizeClass + 1);
+}
+
+size_t MemoryManager::getPoolUsedBytes()
+{
+    LockGuard<RecursiveMutex> mtxlock(mtx);
+    size_t used = 0;
+    for(auto &p : pools) used += p.head - p.mem;
+    return used;
+}
+
+AllocTagCounter &MemoryManager::getTagCounter(size_t tag)
+{
+    // open addressing - slots are never removed, so a lookup only has to CAS an empty slot.
+    // Last slot is reserved for the tags which don't fit.
+    size_t idx = tag % (MAX_ALLOC_TAGS - 1);
+    for(size_t i = 0; i < MAX_ALLOC_TAGS - 1; ++i) {
+        AllocTagCounter &c = tagStats[idx];
+        size_t curr        = c.tag.load(std::memory_order_acquire);
+        if(curr == tag) return c;
+        if(curr == 0) {
+            size_t expected = 0;
+            if(c.tag.compare_exchange_strong(expected, tag, std::memory_order_acq_rel) ||
+               expected == tag)
+            {
+                return c;
+            }
+        }
+        idx = (idx + 1) % (MAX_ALLOC_TAGS - 1);
+    }
+    AllocTagCounter &overflow = tagStats[MAX_ALLOC_TAGS - 1];
+    overflow.tag              = -1;
+    return overflow;
+}
+
+void MemoryManager::tagAlloc(size_t tag, size_t bytes)
+{
+    AllocTagCounter &c = getTagCounter(tag);
+    ++c.allocs;
+    c.liveBytes += bytes;
+}
+void MemoryManager::tagFree(size_t tag, size_t bytes)
+{
+    AllocTagCounter &c = getTagCounter(tag);
+    ++c.frees;
+    c.liveBytes -= bytes;
+}
+
+void MemoryManager::setTagName(size_t tag, StringRef tagName)
+{
+    LockGuard<RecursiveMutex> mtxlock(mtx);
+    tagNames[tag] = tagName;
+}
+
+void MemoryManager::dumpStats()
+{
+    LOG_INFO("=============== ", name, " memory manager live stats: ===============");
+    LOG_INFO("-- Pools: ", pools.size(), " x ", poolSize, " bytes, used: ", getPoolUsedBytes(),
+             " bytes, in free lists: ", freeChunkBytes.load(), " bytes");
+    for(size_t i = 0; i < SIZE_CLASS_COUNT; ++i) {
+        AllocCounter &c = sizeClassStats[i];
+        if(c.allocs == 0) continue;
+        size_t limit = getSizeClassLimit(i);
+        LOG_INFO("-- Size class <= ", limit ? std::to_string(limit) : String("inf"),
+                 ": allocs: ", c.allocs.load(), ", frees: ", c.frees.load(), ", live: ", c.live(),
+                 ", live bytes: ", c.liveBytes.load());
+    }
+    LockGuard<RecursiveMutex> mtxlock(mtx);
+    for(auto &c : tagStats) {
+        if(c.tag == 0) continue;
+        auto loc = tagNames.find(c.tag);
+        LOG_INFO("-- Tag ", loc != tagNames.end() ? loc->second : std::to_string(c.tag.load()),
+                 ": allocs: ", c.allocs.load(),
+                 ", frees: ", c.frees.load(), ", live: ", c.live(),
+                 ", live bytes: ", c.liveBytes.load());
+    }
+}
+
+void MemoryManager::setStatsDumpInterval(size_t intervalMs)
+{
+    if(statsDumper.joinable()) {
+        statsDumper.request_stop();
+        statsDumper.join();
+    }
+    if(intervalMs == 0) return;
+    statsDumper = JThread([this, intervalMs](std::stop_token stoken) {
+        constexpr size_t stepMs = 50;
+        size_t elapsed          = 0;
+        while(!stoken.stop_requested()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(stepMs));
+            elapsed += stepMs;
+            if(elapsed < intervalMs) continue;
+            dumpStats();
+            elapsed = 0;
+        }
+    });
 }
 
 void MemoryManager::dumpMem(char *pool)
@@ -290,4 +419,37 @@ size_t ManagedRawList::clear()
     return count;
 }
 
-} // namespace fer
\ No newline at end of file
+ManagedArena::ManagedArena(MemoryManager &mem, String &&name, size_t blockSize)
+    : mem(mem), name(std::move(name)), head(nullptr), tail(nullptr), blockSize(blockSize)
+{}
+ManagedArena::ManagedArena(MemoryManager &mem, const char *name, size_t blockSize)
+    : mem(mem), name(name), head(nullptr), tail(nullptr), blockSize(blockSize)
+{}
+ManagedArena::~ManagedArena()
+{
+    size_t blockCount = blocks.size();
+    size_t count      = clear();
+    LOG_DEBUG(getName(), " arena had ", count, " allocations in ", blockCount, " block(s)");
+}
+
+void ManagedArena::allocBlock(size_t minSize)
+{
+    size_t sz = minSize > blockSize ? minSize : blockSize;
+    head      = (char *)mem.allocRaw(sz, MAX_ALIGNMENT);
+    tail      = head + sz;
+    blocks.push_back(head);
+}
+
+size_t ManagedArena::clear()
+{
+    size_t count = allocs.size();
+    for(auto it = dtors.rbegin(); it != dtors.rend(); ++it) (*it)->~IAllocated();
+    dtors.clear();
+    allocs.clear();
+    for(auto &b : blocks) mem.freeRaw(b);
+    blocks.clear();
+    head = tail = nullptr;
+    return count;
+}
+
+} // namespace fer
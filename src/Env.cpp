@@ -9,8 +9,9 @@
 #elif defined(FER_OS_FREEBSD)
 #include <sys/sysctl.h> // for sysctl()
 #include <sys/types.h>
-#else
-#include <unistd.h> // for readlink()
+#endif
+#if !defined(FER_OS_WINDOWS)
+#include <unistd.h> // for readlink(), getpid()
 #endif
 
 namespace fer::env
@@ -52,6 +53,15 @@ Path getHome()
 #endif
 }
 
+int getPid()
+{
+#if defined(FER_OS_WINDOWS)
+    return GetCurrentProcessId();
+#else
+    return getpid();
+#endif
+}
+
 Path getProcPath()
 {
     char path[MAX_PATH_CHARS];
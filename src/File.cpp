@@ -1,5 +1,14 @@
 #include "File.hpp"
 
+#if defined(FER_OS_WINDOWS)
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 namespace fer
 {
 
@@ -22,6 +31,7 @@ Status<bool> File::readFile(const char *file, String &data)
 }
 
 File::File(const char *path, bool isVirt) : path(path), isVirt(isVirt) {}
+File::File(const char *path, StringRef data) : path(path), data(data), isVirt(false) {}
 
 Status<bool> File::read()
 {
@@ -55,6 +65,104 @@ StringRef File::getAppendData(size_t index) const
     return StringRef(data.begin() + appendLocs[index], data.begin() + end);
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////// MappedFile ////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+#if defined(FER_OS_WINDOWS)
+MappedFile::MappedFile() : data(nullptr), len(0), fileHandle(nullptr), mapHandle(nullptr) {}
+MappedFile::MappedFile(MappedFile &&other)
+    : data(other.data), len(other.len), fileHandle(other.fileHandle), mapHandle(other.mapHandle)
+{
+    other.data       = nullptr;
+    other.len        = 0;
+    other.fileHandle = nullptr;
+    other.mapHandle  = nullptr;
+}
+#else
+MappedFile::MappedFile() : data(nullptr), len(0) {}
+MappedFile::MappedFile(MappedFile &&other) : data(other.data), len(other.len)
+{
+    other.data = nullptr;
+    other.len  = 0;
+}
+#endif
+MappedFile::~MappedFile() { unmap(); }
+
+MappedFile &MappedFile::operator=(MappedFile &&other)
+{
+    if(this == &other) return *this;
+    unmap();
+    std::swap(data, other.data);
+    std::swap(len, other.len);
+#if defined(FER_OS_WINDOWS)
+    std::swap(fileHandle, other.fileHandle);
+    std::swap(mapHandle, other.mapHandle);
+#endif
+    return *this;
+}
+
+bool MappedFile::map(const char *path)
+{
+    unmap();
+#if defined(FER_OS_WINDOWS)
+    HANDLE file = CreateFileW(utils::sToWString(path).c_str(), GENERIC_READ, FILE_SHARE_READ,
+                              NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if(file == INVALID_HANDLE_VALUE) return false;
+    LARGE_INTEGER fileSize;
+    if(!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+        CloseHandle(file);
+        return false;
+    }
+    HANDLE mapping = CreateFileMappingW(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if(!mapping) {
+        CloseHandle(file);
+        return false;
+    }
+    void *view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if(!view) {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+    data       = (char *)view;
+    len        = fileSize.QuadPart;
+    fileHandle = file;
+    mapHandle  = mapping;
+#else
+    int fd = open(path, O_RDONLY);
+    if(fd < 0) return false;
+    struct stat st;
+    if(fstat(fd, &st) != 0 || st.st_size == 0) {
+        close(fd);
+        return false;
+    }
+    void *view = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // the mapping stays valid after the descriptor is closed
+    close(fd);
+    if(view == MAP_FAILED) return false;
+    data = (char *)view;
+    len  = st.st_size;
+#endif
+    return true;
+}
+
+void MappedFile::unmap()
+{
+    if(!data) return;
+#if defined(FER_OS_WINDOWS)
+    UnmapViewOfFile(data);
+    CloseHandle(mapHandle);
+    CloseHandle(fileHandle);
+    fileHandle = nullptr;
+    mapHandle  = nullptr;
+#else
+    munmap(data, len);
+#endif
+    data = nullptr;
+    len  = 0;
+}
+
 } // namespace fer
 
 #if defined(FER_OS_WINDOWS)
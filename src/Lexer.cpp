@@ -1,8 +1,10 @@
 #include "Lexer.hpp"
 
+#include <bit>
 #include <charconv>
 
 #include "Error.hpp"
+#include "SIMD.hpp"
 
 namespace fer::lex
 {
@@ -121,11 +123,12 @@ const char *TokStrs[_LAST] = {
 
 Tok::Tok(int tok) : val((TokType)tok) {}
 
+static_assert(std::is_trivially_destructible_v<Lexeme::Data> &&
+                  std::is_trivially_destructible_v<Tok>,
+              "the token arena does not run the destructors of lexemes");
+
 Lexeme::Lexeme(ModuleLoc loc) : loc(loc), tok(INVALID) {}
 Lexeme::Lexeme(ModuleLoc loc, TokType type) : loc(loc), tok(type) {}
-Lexeme::Lexeme(ModuleLoc loc, TokType type, String &&_data)
-    : loc(loc), tok(type), data(std::move(_data))
-{}
 Lexeme::Lexeme(ModuleLoc loc, TokType type, StringRef _data) : loc(loc), tok(type), data(_data) {}
 Lexeme::Lexeme(ModuleLoc loc, int64_t _data) : loc(loc), tok(INT), data(_data) {}
 Lexeme::Lexeme(ModuleLoc loc, double _data) : loc(loc), tok(FLT), data(_data) {}
@@ -187,7 +190,69 @@ bool getConstStr(ModuleId moduleId, StringRef data, char &quoteType, size_t &i,
                  size_t &lineStart, StringRef &buf);
 TokType getOperator(ModuleId moduleId, StringRef data, size_t &i, size_t line, size_t lineStart);
 
-bool tokenize(ModuleId moduleId, StringRef path, StringRef data, ManagedList &toks)
+//////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////// SIMD Scanning //////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Helpers to scan long runs (identifiers, whitespace, comments, string contents) multiple bytes at
+// a time. Each of them has a scalar fallback which is also used for the tail of the data.
+
+namespace simd
+{
+using namespace fer::simd;
+
+#if defined(__AVX2__) || defined(__SSE2__)
+inline Vec isIdentChar(Vec c)
+{
+    Vec lower = bor(c, set1(0x20)); // folds A-Z into a-z
+    return bor(bor(inRange(lower, 'a', 'z'), inRange(c, '0', '9')), eq(c, set1('_')));
+}
+#endif
+
+inline bool isIdentChar(char c) { return isalnum(c) || c == '_'; }
+
+// Returns the index of the first character from `i` onwards which is not [a-zA-Z0-9_].
+size_t skipIdent(StringRef data, size_t i)
+{
+    size_t len = data.size();
+#if defined(__AVX2__) || defined(__SSE2__)
+    for(; i + WIDTH <= len; i += WIDTH) {
+        Mask m = ~mask(isIdentChar(load(&data[i]))) & ALL;
+        if(m) return i + std::countr_zero(m);
+    }
+#endif
+    while(i < len && isIdentChar(data[i])) ++i;
+    return i;
+}
+
+// Returns the index of the first non whitespace character from `i` onwards.
+// Updates `line` and `lineStart` for the newlines that are skipped.
+size_t skipSpaces(StringRef data, size_t i, size_t &line, size_t &lineStart)
+{
+    size_t len = data.size();
+#if defined(__AVX2__) || defined(__SSE2__)
+    for(; i + WIDTH <= len; i += WIDTH) {
+        Vec c         = load(&data[i]);
+        Mask nonSpace = ~mask(isSpaceChar(c)) & ALL;
+        Mask newlines = mask(eq(c, set1('\n')));
+        if(nonSpace) newlines &= ((Mask)1 << std::countr_zero(nonSpace)) - 1;
+        if(newlines) {
+            line += std::popcount(newlines);
+            lineStart = i + (std::bit_width(newlines) - 1) + 1;
+        }
+        if(nonSpace) return i + std::countr_zero(nonSpace);
+    }
+#endif
+    for(; i < len && isspace(data[i]); ++i) {
+        if(data[i] != '\n') continue;
+        ++line;
+        lineStart = i + 1;
+    }
+    return i;
+}
+} // namespace simd
+
+bool tokenize(ModuleId moduleId, StringRef path, StringRef data, ManagedArena &toks)
 {
     int commentBlock = 0; // int to handle nested comment blocks
     bool commentLine = false;
@@ -202,12 +267,17 @@ bool tokenize(ModuleId moduleId, StringRef path, StringRef data, ManagedList &to
             lineStart = i + 1;
         }
         if(commentLine) {
-            if(CURR == '\n') commentLine = false;
-            ++i;
+            if(CURR == '\n') {
+                commentLine = false;
+                ++i;
+                continue;
+            }
+            const char *nl = (const char *)memchr(&data[i], '\n', len - i);
+            i              = nl ? nl - data.data() : len;
             continue;
         }
         if(isspace(CURR)) {
-            ++i;
+            i = simd::skipSpaces(data, i + 1, line, lineStart);
             continue;
         }
         if(CURR == '*' && NEXT == '/') {
@@ -226,7 +296,7 @@ bool tokenize(ModuleId moduleId, StringRef path, StringRef data, ManagedList &to
             continue;
         }
         if(commentBlock) {
-            ++i;
+            i = simd::findAny(data, i + 1, '*', '/', '\n');
             continue;
         }
         if(CURR == '#') {
@@ -260,7 +330,7 @@ bool tokenize(ModuleId moduleId, StringRef path, StringRef data, ManagedList &to
                     toks.alloc<Lexeme>(ModuleLoc(moduleId, startPos, i - 1), strClass, str);
                 else
                     toks.alloc<Lexeme>(ModuleLoc(moduleId, startPos, i - 1), strClass,
-                                       std::move(tmpstr));
+                                       toks.allocStr(tmpstr));
             } else {
                 // or the type
                 toks.alloc<Lexeme>(ModuleLoc(moduleId, startPos, i - 1), strClass);
@@ -320,10 +390,7 @@ StringRef getName(StringRef data, size_t &i)
 {
     size_t len   = data.size();
     size_t start = i++; // we know first char is valid, duh
-    while(i < len) {
-        if(!isalnum(CURR) && CURR != '_') break;
-        ++i;
-    }
+    i            = simd::skipIdent(data, i);
     if(i < len && CURR == '?') ++i;
 
     return StringRef(&data[start], i - start);
@@ -469,6 +536,11 @@ bool getConstStr(ModuleId moduleId, StringRef data, char &quoteType, size_t &i,
         ++i;
     }
     while(i < len) {
+        // jump to the next character that needs to be looked at
+        if(continuousBackslash == 0) {
+            i = simd::findAny(data, i, quoteType, '\\', '\n');
+            if(i >= len) break;
+        }
         if(CURR == '\n') {
             ++line;
             lineStart = i + 1;
@@ -683,10 +755,9 @@ TokType getOperator(ModuleId moduleId, StringRef data, size_t &i, size_t line, s
     return opType;
 }
 
-void dumpTokens(OStream &os, const ManagedList &toks)
+void dumpTokens(OStream &os, const ManagedArena &toks)
 {
-    Lexeme *t = nullptr;
-    while((t = (Lexeme *)toks.next(t))) { os << t->str() << "\n"; }
+    for(size_t i = 0; i < toks.size(); ++i) os << ((Lexeme *)toks.at(i))->str() << "\n";
 }
 
 } // namespace fer::lex
\ No newline at end of file
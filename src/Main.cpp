@@ -10,6 +10,8 @@ using namespace fer;
 // `bc` is the output variable here.
 bool ParseSource(VirtualMachine &vm, Bytecode &bc, ModuleId moduleId, StringRef path,
                  StringRef data, bool exprOnly);
+// Tokenizes the file `iterations` times and shows the lexer's throughput.
+int BenchLexer(const Path &srcFile, StringRef iterations);
 
 int main(int argc, char **argv)
 {
@@ -20,12 +22,17 @@ int main(int argc, char **argv)
     args.addArg("parse").addOpts("--parse", "-p").setHelp("shows AST");
     args.addArg("optparse").addOpts("--optparse", "-P").setHelp("shows optimized AST (AST after passes)");
     args.addArg("ir").addOpts("--ir", "-i").setHelp("shows codegen IR");
+    args.addArg("lazy").addOpts("--lazy", "-L").setHelp("import modules on first use of their attributes (unless imported with lazy = false)");
     args.addArg("nobc").addOpts("--nobc", "-n").setHelp("disables usage of cached bytecode files");
     args.addArg("dry").addOpts("--dry", "-d").setHelp("dry run - generate IR but don't run the VM");
     args.addArg("logerr").addOpts("--logerr", "-e").setHelp("show logs on stderr");
     args.addArg("verbose").addOpts("--verbose", "-V").setHelp("show verbose compiler output");
     args.addArg("debug").addOpts("--debug", "-D").setHelp("show debug (more verbose) compiler output");
     args.addArg("trace").addOpts("--trace", "-T").setHelp("show trace (even more verbose) compiler output");
+    args.addArg("lexbench").addOpts("--lexbench").setValReqd(true).setHelp("benchmark lexer throughput by tokenizing the source <value> times");
+    args.addArg("allocprof").addOpts("--allocprof", "-A").setValReqd(true).setHelp("sample allocation sites and write them (folded stacks) to <value> file at exit");
+    args.addArg("allocrate").addOpts("--allocrate").setValReqd(true).setHelp("bytes allocated between allocation profiler samples (default: 65536)");
+    args.addArg("memstats").addOpts("--memstats", "-M").setValReqd(true).setHelp("collect memory stats (see feral.memStats()) and log them (INFO level, see --verbose) every <value> milliseconds (0 = never)");
     args.addArg("source").setHelp("Source file to compile/run");
     args.setLastArg("source");
     // clang-format on
@@ -60,7 +67,20 @@ int main(int argc, char **argv)
         return 1;
     }
 
-    VirtualMachine vm(args, ParseSource, "Main");
+    // The VM throws if it cannot be initialized (like with a missing or corrupted bundle), after
+    // reporting the reason.
+    std::unique_ptr<VirtualMachine> vmPtr;
+    try {
+        vmPtr = std::make_unique<VirtualMachine>(args, ParseSource, "Main");
+    } catch(const char *e) {
+        std::cerr << "FATAL: " << e << "\n";
+        return 1;
+    }
+    VirtualMachine &vm = *vmPtr;
+    if(args.has("memstats")) {
+        String interval(args.getValue("memstats"));
+        vm.getMemoryManager().setStatsDumpInterval(std::strtoull(interval.c_str(), nullptr, 10));
+    }
     if(!fs::exists(srcFile)) {
         Path binFile(vm.getLibPath()->getVal());
         binFile /= "bin";
@@ -73,6 +93,8 @@ int main(int argc, char **argv)
         srcFile = binFile;
     }
     srcFile = fs::absolute(srcFile);
+    if(vm.getBundle()) srcFile = vm.getBundle()->getMainPath();
+    if(args.has("lexbench")) return BenchLexer(srcFile, args.getValue("lexbench"));
     return vm.compileAndRun({}, srcFile.string().c_str(), nullptr);
 }
 
@@ -83,7 +105,7 @@ bool ParseSource(VirtualMachine &vm, Bytecode &bc, ModuleId moduleId, StringRef
 
     // Separate allocator for tokens since we don't want the them to persist outside
     // this function - because this function is supposed to generate IR for the VM to consume.
-    ManagedList tokens(mem, "TokensList");
+    ManagedArena tokens(mem, "Tokens");
     if(!lex::tokenize(moduleId, path, data, tokens)) {
         std::cout << "Failed to tokenize file: " << path << "\n";
         return false;
@@ -98,7 +120,7 @@ bool ParseSource(VirtualMachine &vm, Bytecode &bc, ModuleId moduleId, StringRef
 
     // Separate allocator for AST since we don't want the AST nodes (Stmt) to persist outside
     // this function - because this function is supposed to generate IR for the VM to consume.
-    ManagedList astallocator(mem, utils::toString("AST(", path, ")"));
+    ManagedArena astallocator(mem, utils::toString("AST(", path, ")"));
     ast::Stmt *ptree = nullptr;
     if(!ast::parse(astallocator, tokens, ptree, exprOnly)) {
         std::cout << "Failed to parse tokens for file: " << path << "\n";
@@ -128,4 +150,37 @@ bool ParseSource(VirtualMachine &vm, Bytecode &bc, ModuleId moduleId, StringRef
         bc.dump(std::cout);
     }
     return true;
-}
\ No newline at end of file
+}
+
+int BenchLexer(const Path &srcFile, StringRef iterations)
+{
+    String path = srcFile.string();
+    String data;
+    Status<bool> readRes = File::readFile(path.c_str(), data);
+    if(!readRes.getCode()) {
+        err.fail({}, readRes.getMsg());
+        return 1;
+    }
+    size_t iters = std::strtoull(String(iterations).c_str(), nullptr, 10);
+    if(iters == 0) iters = 1;
+
+    MemoryManager mem("LexerBench");
+    size_t tokCount = 0;
+    auto start      = std::chrono::steady_clock::now();
+    for(size_t i = 0; i < iters; ++i) {
+        ManagedArena tokens(mem, "Tokens");
+        if(!lex::tokenize(0, path, data, tokens)) {
+            std::cerr << "Failed to tokenize file: " << path << "\n";
+            return 1;
+        }
+        tokCount = tokens.size();
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    double secs = std::chrono::duration<double>(end - start).count();
+    double mb   = (double)data.size() * iters / (1024.0 * 1024.0);
+    std::cout << "Lexed " << path << " (" << data.size() << " bytes, " << tokCount
+              << " tokens) " << iters << " times in " << secs * 1000.0 << " ms: " << mb / secs
+              << " MB/s\n";
+    return 0;
+}
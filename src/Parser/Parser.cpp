@@ -3,14 +3,14 @@
 namespace fer::ast
 {
 
-bool parse(ManagedList &allocator, ManagedList &toks, Stmt *&s, bool exprOnly)
+bool parse(ManagedArena &allocator, ManagedArena &toks, Stmt *&s, bool exprOnly)
 {
     Parser parser(allocator, toks);
     return exprOnly ? parser.parseExpr(s) : parser.parseBlock((StmtBlock *&)s, false);
 }
 void dumpTree(OStream &os, Stmt *tree) { tree->disp(false); }
 
-Parser::Parser(ManagedList &allocator, ManagedList &toks) : allocator(allocator), p(toks) {}
+Parser::Parser(ManagedArena &allocator, ManagedArena &toks) : allocator(allocator), p(toks) {}
 
 // on successful parse, returns true, and tree is allocated
 // if withBrace is true, it will attempt to find the beginning and ending brace for each block
@@ -41,7 +41,10 @@ bool Parser::parseBlock(StmtBlock *&tree, bool withBrace)
             if(!parseConds(stmt)) return false;
             skipCols = true;
         } else if(p.accept(lex::FOR)) {
-            if(p.peekt(1) == lex::IDEN && p.peekt(2) == lex::FIN) {
+            if(p.peekt(1) == lex::IDEN &&
+               (p.peekt(2) == lex::FIN || (p.peekt(2) == lex::COMMA && p.peekt(3) == lex::IDEN &&
+                                           p.peekt(4) == lex::FIN)))
+            {
                 if(!parseForIn(stmt)) return false;
             } else {
                 if(!parseFor(stmt)) return false;
@@ -1207,7 +1210,24 @@ for ; ; {
     if x == nil { break; }
     ...
 }
+
+With two iterators (for key-value pairs), `for k, v in map.each() {...}`, the pair itself is
+stored in a hidden variable, and before the loop body:
+    let k = ref(__x.0);
+    let v = ref(__x.1);
 */
+// let <name> = ref(<pairName>.<elem>);
+StmtVar *Parser::makePairElemVar(ModuleLoc loc, StringRef name, StringRef pairName, StringRef elem)
+{
+    StmtSimple *pair      = StmtSimple::create(allocator, loc, lex::IDEN, pairName);
+    StmtSimple *elemRHS   = StmtSimple::create(allocator, loc, lex::STR, elem);
+    StmtExpr *elemExpr    = StmtExpr::create(allocator, loc, pair, lex::DOT, elemRHS);
+    StmtSimple *refSimple = StmtSimple::create(allocator, loc, lex::IDEN, StringRef("ref"));
+    StmtFnArgs *refArgs   = StmtFnArgs::create(allocator, loc, {elemExpr}, {false});
+    StmtExpr *refCall     = StmtExpr::create(allocator, loc, refSimple, lex::FNCALL, refArgs);
+    return StmtVar::create(allocator, loc, name, nullptr, refCall, false);
+}
+
 bool Parser::parseForIn(Stmt *&fin)
 {
     fin = nullptr;
@@ -1230,11 +1250,35 @@ bool Parser::parseForIn(Stmt *&fin)
     ModuleLoc iterLoc  = p.peek()->getLoc();
     p.next();
 
+    StringRef valName;
+    ModuleLoc valLoc;
+    if(p.acceptn(lex::COMMA)) {
+        if(!p.accept(lex::IDEN)) {
+            err.fail(p.peek()->getLoc(), "expected value iterator (identifier) here, found: ",
+                     p.peek()->getTok().cStr());
+            return false;
+        }
+        valName = p.peek()->getDataStr();
+        valLoc  = p.peek()->getLoc();
+        p.next();
+    }
+
     static size_t __iterCtr = 0;
     String __iterName       = "__";
     __iterName += iterName;
     __iterName += std::to_string(__iterCtr++);
 
+    // the key and value are extracted from the hidden pair variable
+    String __pairName;
+    StringRef keyName;
+    ModuleLoc keyLoc;
+    if(!valName.empty()) {
+        keyName    = iterName;
+        keyLoc     = iterLoc;
+        __pairName = __iterName + "__pair";
+        iterName   = __pairName;
+    }
+
     if(!p.acceptn(lex::FIN)) {
         err.fail(p.peek()->getLoc(), "expected 'in' here, found: ", p.peek()->getTok().cStr());
         return false;
@@ -1281,6 +1325,12 @@ bool Parser::parseForIn(Stmt *&fin)
     Conditional c(nilCheck, breakBlk);
     StmtCond *breakCond = StmtCond::create(allocator, iterLoc, {c});
 
+    if(!valName.empty()) {
+        // let v = ref(__x.1);
+        blk->insertStmt(0, makePairElemVar(valLoc, valName, iterName, "1"));
+        // let k = ref(__x.0);
+        blk->insertStmt(0, makePairElemVar(keyLoc, keyName, iterName, "0"));
+    }
     blk->insertStmt(0, breakCond);
     blk->insertStmt(0, iterVar);
 
@@ -3,23 +3,16 @@
 namespace fer::ast
 {
 
-ParseHelper::ParseHelper(const ManagedList &toks, lex::Lexeme *curr)
-    : toks(toks), invalid({}, lex::INVALID), eof({}, lex::FEOF),
-      curr(curr ? curr : (lex::Lexeme *)toks.getStart())
-{}
+ParseHelper::ParseHelper(const ManagedArena &toks, size_t begin)
+    : toks(toks), invalid({}, lex::INVALID), eof({}, lex::FEOF), curr(nullptr), currIdx(begin)
+{
+    curr = getAt(currIdx);
+}
 
-lex::Lexeme *ParseHelper::getAt(lex::Lexeme *from, int offset)
+lex::Lexeme *ParseHelper::getAt(ssize_t idx)
 {
-    lex::Lexeme *iter = from;
-    while(offset < 0 && iter) {
-        iter = (lex::Lexeme *)toks.prev(iter);
-        ++offset;
-    }
-    while(offset > 0 && iter) {
-        iter = (lex::Lexeme *)toks.next(iter);
-        --offset;
-    }
-    return iter ? iter : &eof;
+    if(idx < 0 || idx >= (ssize_t)toks.size()) return &eof;
+    return (lex::Lexeme *)toks.at(idx);
 }
 
 lex::TokType ParseHelper::peekt(int offset)
@@ -3,7 +3,7 @@
 namespace fer::ast
 {
 
-Pass::Pass(size_t passid, ManagedList &allocator) : passid(passid), allocator(allocator) {}
+Pass::Pass(size_t passid, ManagedArena &allocator) : passid(passid), allocator(allocator) {}
 Pass::~Pass() {}
 
 PassManager::PassManager() {}
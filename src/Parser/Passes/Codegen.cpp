@@ -5,7 +5,7 @@
 namespace fer::ast
 {
 
-CodegenPass::CodegenPass(ManagedList &allocator, Bytecode &bc)
+CodegenPass::CodegenPass(ManagedArena &allocator, Bytecode &bc)
     : Pass(Pass::genPassID<CodegenPass>(), allocator), bc(bc)
 {}
 CodegenPass::~CodegenPass() {}
@@ -129,6 +129,12 @@ bool CodegenPass::visit(StmtExpr *stmt, Stmt **source)
 
     size_t orInstrPos = 0;
 
+    if(oper == lex::ADD && stmt->getLHS()->isExpr() &&
+       as<StmtExpr>(stmt->getLHS())->getOper() == lex::ADD)
+    {
+        return visitAddChain(stmt);
+    }
+
     // handle member function call - we don't want ATTR instr to be emitted so we take care
     // of the whole thing ourselves
     if(oper == lex::FNCALL && stmt->getLHS()->isExpr()) {
@@ -215,6 +221,30 @@ end:
     return true;
 }
 
+bool CodegenPass::visitAddChain(StmtExpr *stmt)
+{
+    // `a + b + c` is parsed as `(a + b) + c`, so the operands are collected from the LHS chain
+    Vector<Stmt **> operands;
+    StmtExpr *curr = stmt;
+    while(true) {
+        operands.push_back(&curr->getRHS());
+        Stmt *lhs = curr->getLHS();
+        if(!lhs->isExpr() || as<StmtExpr>(lhs)->getOper() != lex::ADD) {
+            operands.push_back(&curr->getLHS());
+            break;
+        }
+        curr = as<StmtExpr>(lhs);
+    }
+    for(auto it = operands.rbegin(); it != operands.rend(); ++it) {
+        if(!visit(**it, *it)) {
+            err.fail((**it)->getLoc(), "failed to generate code for operand of addition");
+            return false;
+        }
+    }
+    bc.addInstrInt(Opcode::ADD_CHAIN, stmt->getLoc(), operands.size());
+    return true;
+}
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 //////////////////////////////////////////// StmtVar //////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////////////////////////
@@ -5,6 +5,20 @@
 namespace fer::ast
 {
 
+// Strings repeated (`str * count`) at compile time must not be longer than this, since they are
+// stored in the bytecode.
+constexpr size_t MAX_FOLDED_REPEAT_LEN = 4096;
+
+static bool canFoldRepeat(StringRef str, int64_t count)
+{
+    return count >= 0 && (str.empty() || (uint64_t)count <= MAX_FOLDED_REPEAT_LEN / str.size());
+}
+static bool isZero(StmtSimple *s)
+{
+    return (s->getTokType() == lex::INT && s->getDataInt() == 0) ||
+           (s->getTokType() == lex::FLT && s->getDataFlt() == 0.0);
+}
+
 template<typename T> T getValueAs(StmtSimple *s)
 {
     T res = 0;
@@ -73,14 +87,18 @@ bool SimplifyPass::applyConstantFolding(Stmt *&resultStmt, StmtSimple *l, StmtSi
     }
     case lex::MUL: {
         // "xyz" * 2 = "xyzxyz"
-        if(ltok == lex::STR && rtok == lex::INT) {
+        if(ltok == lex::STR && rtok == lex::INT &&
+           canFoldRepeat(l->getDataStr(), r->getDataInt()))
+        {
             String res;
             res.reserve(l->getDataStr().size() * r->getDataInt());
             for(int64_t i = 0; i < r->getDataInt(); ++i) { res += l->getDataStr(); }
             resultStmt = StmtSimple::create(allocator, l->getLoc(), lex::STR, std::move(res));
         }
         // 2 * "xyz" = "xyzxyz"
-        if(ltok == lex::INT && rtok == lex::STR) {
+        if(ltok == lex::INT && rtok == lex::STR &&
+           canFoldRepeat(r->getDataStr(), l->getDataInt()))
+        {
             String res;
             res.reserve(l->getDataInt() * r->getDataStr().size());
             for(int64_t i = 0; i < l->getDataInt(); ++i) { res += r->getDataStr(); }
@@ -90,17 +108,13 @@ bool SimplifyPass::applyConstantFolding(Stmt *&resultStmt, StmtSimple *l, StmtSi
         break;
     }
     case lex::DIV: {
-        if((rtok == lex::INT && r->getDataInt() == 0) ||
-           (rtok == lex::FLT && r->getDataFlt() == 0.0))
-        {
-            err.fail(l->getLoc(), "Attempted to divide by zero during constant folding pass");
-            return false;
-        }
+        // a division by zero is left to fail at runtime, where it can be handled (with `or`)
+        if(isZero(r)) break;
         binaryIntFltOps(/);
         break;
     }
     case lex::MOD: {
-        if(ltok == lex::INT && rtok == lex::INT) {
+        if(ltok == lex::INT && rtok == lex::INT && !isZero(r)) {
             int64_t res = l->getDataInt() % r->getDataInt();
             resultStmt  = StmtSimple::create(allocator, l->getLoc(), lex::INT, res);
         }
@@ -0,0 +1,208 @@
+// part of SimplifyPass
+
+#include "AST/Passes/Simplify.hpp"
+
+namespace fer::ast
+{
+
+UseDefInfo::UseDefInfo() : blkDepth(0) {}
+
+bool UseDefInfo::isReadOnlyOper(lex::TokType oper)
+{
+    switch(oper) {
+    case lex::ADD:
+    case lex::SUB:
+    case lex::MUL:
+    case lex::DIV:
+    case lex::MOD:
+    case lex::POWER:
+    case lex::USUB:
+    case lex::LNOT:
+    case lex::EQ:
+    case lex::NE:
+    case lex::LT:
+    case lex::GT:
+    case lex::LE:
+    case lex::GE:
+    case lex::BAND:
+    case lex::BOR:
+    case lex::BNOT:
+    case lex::BXOR:
+    case lex::LSHIFT:
+    case lex::RSHIFT: return true;
+    default: break;
+    }
+    return false;
+}
+
+void UseDefInfo::analyze(Stmt *root)
+{
+    fnBlks.push_back(nullptr);
+    collect(root, true);
+    fnBlks.pop_back();
+}
+
+bool UseDefInfo::canPropagate(StmtBlock *fnBlk, StringRef name)
+{
+    if(unsafeNames.contains(String(name))) return false;
+    auto decls = declCounts.find(fnBlk);
+    if(decls == declCounts.end()) return false;
+    auto count = decls->second.find(name);
+    return count != decls->second.end() && count->second == 1;
+}
+
+bool UseDefInfo::isShadowed(StmtBlock *fnBlk, StringRef name)
+{
+    if(!fnBlk) return moduleBlockNames.contains(String(name));
+    auto decls = declCounts.find(fnBlk);
+    return decls == declCounts.end() || decls->second.find(name) != decls->second.end();
+}
+
+void UseDefInfo::collectStrNames(StringRef str)
+{
+    size_t begin = 0;
+    for(size_t i = 0; i <= str.size(); ++i) {
+        if(i < str.size() && (isalnum(str[i]) || str[i] == '_')) continue;
+        if(i > begin) unsafeNames.insert(String(str.substr(begin, i - begin)));
+        begin = i + 1;
+    }
+}
+
+void UseDefInfo::collect(Stmt *stmt, bool readOnly)
+{
+    if(!stmt) return;
+    switch(stmt->getStmtType()) {
+    case BLOCK: {
+        StmtBlock *blk = as<StmtBlock>(stmt);
+        ++blkDepth;
+        // the last value of a block which is not unloaded (ternary) is its result
+        for(auto &s : blk->getStmts()) collect(s, blk->shouldUnload() || readOnly);
+        --blkDepth;
+        break;
+    }
+    case SIMPLE: {
+        StmtSimple *s = as<StmtSimple>(stmt);
+        if(s->getTokType() == lex::IDEN && !readOnly) unsafeNames.insert(String(s->getDataStr()));
+        else if(s->getTokType() == lex::STR) collectStrNames(s->getDataStr());
+        break;
+    }
+    case EXPR: {
+        StmtExpr *e       = as<StmtExpr>(stmt);
+        lex::TokType oper = e->getOper();
+        // && and || result in one of their operands
+        bool childReadOnly = isReadOnlyOper(oper) ||
+                             ((oper == lex::LAND || oper == lex::LOR) && readOnly);
+        // calling a function does not modify the variable it's stored in
+        collect(e->getLHS(), childReadOnly || oper == lex::FNCALL);
+        // RHS of dot operation is the attribute name
+        if(oper != lex::DOT) collect(e->getRHS(), childReadOnly);
+        break;
+    }
+    case FNARGS: {
+        for(auto &a : as<StmtFnArgs>(stmt)->getArgs()) collect(a, false);
+        break;
+    }
+    case VAR: {
+        StmtVar *v = as<StmtVar>(stmt);
+        if(!v->isArg()) {
+            ++declCounts[fnBlks.back()][String(v->getName())];
+            if(!fnBlks.back() && blkDepth > 1) moduleBlockNames.insert(String(v->getName()));
+        }
+        collect(v->getIn(), false);
+        // the value is copied when a variable is created, but not for args
+        collect(v->getVal(), !v->isArg());
+        break;
+    }
+    case FNDEF: {
+        StmtFnDef *fn = as<StmtFnDef>(stmt);
+        fnBlks.push_back(fn->getBlk());
+        auto &decls = declCounts[fn->getBlk()];
+        for(auto &a : fn->getSigArgs()) {
+            ++decls[String(a->getName())];
+            collect(a->getVal(), false);
+        }
+        if(fn->getKwArg()) ++decls[String(fn->getKwArg()->getDataStr())];
+        if(fn->getVaArg()) ++decls[String(fn->getVaArg()->getDataStr())];
+        collect(fn->getBlk(), true);
+        fnBlks.pop_back();
+        break;
+    }
+    case VARDECL: {
+        for(auto &d : as<StmtVarDecl>(stmt)->getDecls()) collect(d, true);
+        break;
+    }
+    case COND: {
+        for(auto &c : as<StmtCond>(stmt)->getConditionals()) {
+            collect(c.getCond(), true);
+            collect(c.getBlk(), readOnly);
+        }
+        break;
+    }
+    case FOR: {
+        StmtFor *f = as<StmtFor>(stmt);
+        // the variables in init belong to the loop's block
+        ++blkDepth;
+        collect(f->getInit(), true);
+        collect(f->getCond(), true);
+        collect(f->getIncr(), true);
+        collect(f->getBlk(), true);
+        --blkDepth;
+        break;
+    }
+    case RET: collect(as<StmtRetYield>(stmt)->getVal(), false); break;
+    case DEFER: collect(as<StmtDefer>(stmt)->getDeferVal(), true); break;
+    case FNSIG:
+    case CONTINUE:
+    case BREAK: break;
+    }
+}
+
+Stmt *SimplifyPass::getConstant(StringRef name)
+{
+    for(size_t i = constScopes.size(); i > fnScopes.back().firstScope; --i) {
+        auto loc = constScopes[i - 1].find(name);
+        if(loc != constScopes[i - 1].end()) return loc->second;
+    }
+    return nullptr;
+}
+
+// Returns 1 if the literal is truthy, 0 if it's not, and -1 if it's unknown (or invalid).
+static int getTruthiness(Stmt *stmt)
+{
+    if(!stmt || !stmt->isSimple()) return -1;
+    StmtSimple *s = as<StmtSimple>(stmt);
+    switch(s->getTokType()) {
+    case lex::FTRUE: return 1;
+    case lex::FFALSE:
+    case lex::NIL: return 0;
+    case lex::INT: return s->getDataInt() != 0;
+    case lex::FLT: return s->getDataFlt() != 0.0;
+    default: break;
+    }
+    return -1;
+}
+
+void SimplifyPass::removeDeadBranches(StmtCond *stmt, Stmt **source)
+{
+    auto &conds = stmt->getConditionals();
+    for(size_t i = 0; i < conds.size(); ++i) {
+        int truth = getTruthiness(conds[i].getCond());
+        if(truth == 0) {
+            conds.erase(conds.begin() + i);
+            --i;
+        } else if(truth == 1) {
+            // this is the last conditional which can be executed, so it's the else part now
+            conds[i].getCond() = nullptr;
+            conds.erase(conds.begin() + i + 1, conds.end());
+            break;
+        }
+    }
+    if(conds.empty()) *source = nullptr;
+}
+
+void SimplifyPass::removeDeadLoop(StmtFor *stmt, Stmt **source)
+{
+    if(!stmt->getInit() && getTruthiness(stmt->getCond()) == 0) *source = nullptr;
+}
+
+} // namespace fer::ast
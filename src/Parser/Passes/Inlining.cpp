@@ -0,0 +1,207 @@
+// part of SimplifyPass
+
+#include "AST/Passes/Simplify.hpp"
+
+namespace fer::ast
+{
+
+// Max number of statements in the body of an inlinable function
+constexpr size_t MAX_INLINE_SIZE = 16;
+
+StmtSimple *SimplifyPass::copySimple(StmtSimple *stmt, ModuleLoc loc)
+{
+    lex::TokType tok = stmt->getTokType();
+    if(stmt->hasDataStr()) return StmtSimple::create(allocator, loc, tok, stmt->getDataStr());
+    if(stmt->hasDataFlt()) return StmtSimple::create(allocator, loc, tok, stmt->getDataFlt());
+    return StmtSimple::create(allocator, loc, tok, stmt->getDataInt());
+}
+
+bool SimplifyPass::isInlinable(StmtFnDef *fn)
+{
+    if(!fn->getSig()->createStack() || fn->getKwArg() || fn->getVaArg()) return false;
+    for(auto &a : fn->getSigArgs()) {
+        Stmt *def = a->getVal();
+        if(!def) continue;
+        if(!def->isSimple()) return false;
+        StmtSimple *s = as<StmtSimple>(def);
+        if(!s->getTok().isLiteral() && s->getTokType() != lex::NIL) return false;
+    }
+    auto &stmts = fn->getBlk()->getStmts();
+    if(stmts.size() != 1 || !stmts[0]->isReturn()) return false;
+    StmtRetYield *ret = as<StmtRetYield>(stmts[0]);
+    if(ret->isYield() || !ret->getVal()) return false;
+    size_t size = 0;
+    return getInlineSize(ret->getVal(), size) && size <= MAX_INLINE_SIZE;
+}
+
+bool SimplifyPass::getInlineSize(Stmt *stmt, size_t &size)
+{
+    if(!stmt) return true;
+    ++size;
+    switch(stmt->getStmtType()) {
+    case SIMPLE: {
+        // self is only set for member functions
+        StmtSimple *s = as<StmtSimple>(stmt);
+        return s->getTokType() != lex::IDEN || s->getDataStr() != "self";
+    }
+    case EXPR: {
+        StmtExpr *e       = as<StmtExpr>(stmt);
+        lex::TokType oper = e->getOper();
+        if(!UseDefInfo::isReadOnlyOper(oper) && oper != lex::LAND && oper != lex::LOR &&
+           oper != lex::DOT && oper != lex::FNCALL && oper != lex::SUBS)
+        {
+            return false;
+        }
+        // Any other callee may depend on the caller's scope, where the params would not exist
+        // after inlining - like the reflection functions (feral.evalExpr(), varExists(), ...)
+        // and the string templates (Str.fmt()), even through an alias. So only the calls to the
+        // (already known) inlinable functions are allowed, without string literal args which
+        // could be evaluated as code or templates.
+        if(oper == lex::FNCALL) {
+            Stmt *callee = e->getLHS();
+            if(!callee->isSimple() || as<StmtSimple>(callee)->getTokType() != lex::IDEN ||
+               !getInlineFn(as<StmtSimple>(callee)->getDataStr()))
+            {
+                return false;
+            }
+            for(auto &a : as<StmtFnArgs>(e->getRHS())->getArgs()) {
+                if(a->isSimple() && as<StmtSimple>(a)->getTokType() == lex::STR) return false;
+            }
+        }
+        return getInlineSize(e->getLHS(), size) && getInlineSize(e->getRHS(), size);
+    }
+    case FNARGS: {
+        for(auto &a : as<StmtFnArgs>(stmt)->getArgs()) {
+            if(!getInlineSize(a, size)) return false;
+        }
+        return true;
+    }
+    case VAR: {
+        StmtVar *v = as<StmtVar>(stmt);
+        return v->isArg() && !v->getIn() && getInlineSize(v->getVal(), size);
+    }
+    case COND: {
+        // only ternary expressions
+        for(auto &c : as<StmtCond>(stmt)->getConditionals()) {
+            StmtBlock *blk = c.getBlk();
+            if(blk->shouldUnload() || blk->getStmts().size() != 1) return false;
+            if(!getInlineSize(c.getCond(), size) || !getInlineSize(blk->getStmts()[0], size)) {
+                return false;
+            }
+        }
+        return true;
+    }
+    default: break;
+    }
+    return false;
+}
+
+StmtFnDef *SimplifyPass::getInlineFn(StringRef name)
+{
+    Stmt *fn = getConstant(name);
+    // the top level functions of the module are visible in all the functions which don't hide them
+    if(!fn && fnScopes.size() > 1 && !usedefs.isShadowed(fnScopes.back().blk, name)) {
+        auto loc = constScopes.front().find(name);
+        if(loc != constScopes.front().end()) fn = loc->second;
+    }
+    return fn && fn->isFnDef() ? as<StmtFnDef>(fn) : nullptr;
+}
+
+Stmt *SimplifyPass::inlineCall(StmtExpr *call)
+{
+    Stmt *lhs = call->getLHS();
+    if(!lhs->isSimple() || as<StmtSimple>(lhs)->getTokType() != lex::IDEN) return nullptr;
+    StmtFnDef *fn = getInlineFn(as<StmtSimple>(lhs)->getDataStr());
+    if(!fn) return nullptr;
+    StmtFnArgs *callArgs = as<StmtFnArgs>(call->getRHS());
+    auto &params         = fn->getSigArgs();
+    size_t argCount      = callArgs->getArgs().size();
+    // the first param is self
+    if(argCount >= params.size()) return nullptr;
+    // only variables and literals are substituted, so that their evaluation order and count
+    // do not matter
+    StringMap<StmtSimple *> args;
+    for(size_t i = 1; i < params.size(); ++i) {
+        bool given = i <= argCount;
+        Stmt *a    = given ? callArgs->getArg(i - 1) : params[i]->getVal();
+        if(!a || !a->isSimple() || (given && callArgs->unpackArg(i - 1))) return nullptr;
+        args[String(params[i]->getName())] = as<StmtSimple>(a);
+    }
+    return cloneInline(as<StmtRetYield>(fn->getBlk()->getStmts()[0])->getVal(), args);
+}
+
+Stmt *SimplifyPass::cloneInline(Stmt *stmt, StringMap<StmtSimple *> &args)
+{
+    if(!stmt) return nullptr;
+    switch(stmt->getStmtType()) {
+    case SIMPLE: {
+        StmtSimple *s = as<StmtSimple>(stmt);
+        if(s->getTokType() != lex::IDEN) return copySimple(s, s->getLoc());
+        auto arg = args.find(s->getDataStr());
+        if(arg != args.end()) return copySimple(arg->second, arg->second->getLoc());
+        // the callee would find a different variable with this name
+        if(usedefs.isShadowed(fnScopes.back().blk, s->getDataStr())) return nullptr;
+        return copySimple(s, s->getLoc());
+    }
+    case EXPR: {
+        StmtExpr *e       = as<StmtExpr>(stmt);
+        lex::TokType oper = e->getOper();
+        Stmt *lhs         = cloneInline(e->getLHS(), args);
+        if(!lhs) return nullptr;
+        Stmt *rhs = nullptr;
+        if(oper == lex::DOT) {
+            rhs = copySimple(as<StmtSimple>(e->getRHS()), e->getRHS()->getLoc());
+        } else if(e->getRHS() && !(rhs = cloneInline(e->getRHS(), args))) {
+            return nullptr;
+        }
+        // a division by zero must fail at runtime, like it would in the callee
+        if((oper == lex::DIV || oper == lex::MOD) && rhs->isSimple()) {
+            StmtSimple *r = as<StmtSimple>(rhs);
+            if((r->getTokType() == lex::INT && r->getDataInt() == 0) ||
+               (r->getTokType() == lex::FLT && r->getDataFlt() == 0.0))
+            {
+                return nullptr;
+            }
+        }
+        return StmtExpr::create(allocator, e->getLoc(), lhs, oper, rhs);
+    }
+    case FNARGS: {
+        StmtFnArgs *fa = as<StmtFnArgs>(stmt);
+        Vector<Stmt *> newArgs;
+        Vector<bool> unpackVector;
+        for(size_t i = 0; i < fa->getArgs().size(); ++i) {
+            Stmt *a = cloneInline(fa->getArg(i), args);
+            if(!a) return nullptr;
+            newArgs.push_back(a);
+            unpackVector.push_back(fa->unpackArg(i));
+        }
+        return StmtFnArgs::create(allocator, fa->getLoc(), std::move(newArgs),
+                                  std::move(unpackVector));
+    }
+    case VAR: {
+        StmtVar *v = as<StmtVar>(stmt);
+        Stmt *val  = cloneInline(v->getVal(), args);
+        if(!val) return nullptr;
+        return StmtVar::create(allocator, v->getLoc(), v->getName(), nullptr, val, true);
+    }
+    case COND: {
+        StmtCond *c = as<StmtCond>(stmt);
+        Vector<Conditional> conds;
+        for(auto &cond : c->getConditionals()) {
+            Stmt *condExpr = nullptr;
+            if(cond.getCond() && !(condExpr = cloneInline(cond.getCond(), args))) return nullptr;
+            StmtBlock *blk = cond.getBlk();
+            Stmt *val      = cloneInline(blk->getStmts()[0], args);
+            if(!val) return nullptr;
+            StmtBlock *newBlk = StmtBlock::create(allocator, blk->getLoc(), {val}, blk->isTop());
+            newBlk->setUnload(false);
+            conds.emplace_back(condExpr, newBlk);
+        }
+        return StmtCond::create(allocator, c->getLoc(), conds);
+    }
+    default: break;
+    }
+    return nullptr;
+}
+
+} // namespace fer::ast
@@ -41,13 +41,19 @@ void DeferStack::applyDefers(Vector<Stmt *> &stmts)
     }
 }
 
-SimplifyPass::SimplifyPass(ManagedList &allocator)
-    : Pass(Pass::genPassID<SimplifyPass>(), allocator)
+SimplifyPass::SimplifyPass(ManagedArena &allocator)
+    : Pass(Pass::genPassID<SimplifyPass>(), allocator), fnScopes({{nullptr, 0}}), analyzed(false),
+      inlineCalls(true)
 {}
 SimplifyPass::~SimplifyPass() {}
 
 bool SimplifyPass::visit(Stmt *stmt, Stmt **source)
 {
+    // the first statement is the root of the tree
+    if(!analyzed) {
+        usedefs.analyze(stmt);
+        analyzed = true;
+    }
     switch(stmt->getStmtType()) {
     case BLOCK: return visit(as<StmtBlock>(stmt), source);
     case SIMPLE: return visit(as<StmtSimple>(stmt), source);
@@ -72,6 +78,7 @@ bool SimplifyPass::visit(Stmt *stmt, Stmt **source)
 bool SimplifyPass::visit(StmtBlock *stmt, Stmt **source)
 {
     defers.pushLayer();
+    constScopes.emplace_back();
     auto &stmts = stmt->getStmts();
     for(size_t i = 0; i < stmts.size(); ++i) {
         if(!visit(stmts[i], &stmts[i])) {
@@ -86,9 +93,16 @@ bool SimplifyPass::visit(StmtBlock *stmt, Stmt **source)
     }
     defers.applyDefers(stmts);
     defers.popLayer();
+    constScopes.pop_back();
+    return true;
+}
+bool SimplifyPass::visit(StmtSimple *stmt, Stmt **source)
+{
+    if(stmt->getTokType() != lex::IDEN) return true;
+    Stmt *val = getConstant(stmt->getDataStr());
+    if(val && val->isSimple()) *source = copySimple(as<StmtSimple>(val), stmt->getLoc());
     return true;
 }
-bool SimplifyPass::visit(StmtSimple *stmt, Stmt **source) { return true; }
 bool SimplifyPass::visit(StmtFnArgs *stmt, Stmt **source)
 {
     auto &args = stmt->getArgs();
@@ -108,11 +122,20 @@ bool SimplifyPass::visit(StmtExpr *stmt, Stmt **source)
         err.fail(stmt->getLoc(), "failed to apply simplify pass on LHS in expression");
         return false;
     }
-    if(rhs && !visit(rhs, &rhs)) {
-        err.fail(stmt->getLoc(), "failed to apply simplify pass on LHS in expression");
+    // RHS of dot operation is the attribute name, not a variable
+    if(rhs && stmt->getOper() != lex::DOT && !visit(rhs, &rhs)) {
+        err.fail(stmt->getLoc(), "failed to apply simplify pass on RHS in expression");
         return false;
     }
-
+    if(stmt->getOper() == lex::FNCALL && inlineCalls) {
+        Stmt *body = inlineCall(stmt);
+        if(!body) return true;
+        *source     = body;
+        inlineCalls = false;
+        bool res    = visit(body, source);
+        inlineCalls = true;
+        return res;
+    }
     // constant folding
     if(!lhs->isSimple()) return true;
     if(rhs && !rhs->isSimple()) return true;
@@ -129,6 +152,17 @@ bool SimplifyPass::visit(StmtVar *stmt, Stmt **source)
         err.fail(stmt->getLoc(), "failed to apply simplify pass on var: ", stmt->getName());
         return false;
     }
+    Stmt *val = stmt->getVal();
+    if(stmt->isArg() || stmt->getIn() || !val || constScopes.empty()) return true;
+    if(val->isSimple()) {
+        lex::TokType valType = as<StmtSimple>(val)->getTokType();
+        if(!as<StmtSimple>(val)->getTok().isLiteral() && valType != lex::NIL) return true;
+    } else if(!val->isFnDef() || !isInlinable(as<StmtFnDef>(val))) {
+        return true;
+    }
+    if(usedefs.canPropagate(fnScopes.back().blk, stmt->getName())) {
+        constScopes.back()[String(stmt->getName())] = val;
+    }
     return true;
 }
 bool SimplifyPass::visit(StmtFnSig *stmt, Stmt **source)
@@ -149,11 +183,13 @@ bool SimplifyPass::visit(StmtFnSig *stmt, Stmt **source)
 }
 bool SimplifyPass::visit(StmtFnDef *stmt, Stmt **source)
 {
+    fnScopes.push_back({stmt->getBlk(), constScopes.size()});
     if(!visit(stmt->getSig(), asStmt(&stmt->getSig()))) {
         err.fail(stmt->getLoc(), "failed to apply simplify pass on func signature in definition");
         return false;
     }
     if(!stmt->getSig()) {
+        fnScopes.pop_back();
         *source = nullptr;
         return true;
     }
@@ -161,6 +197,7 @@ bool SimplifyPass::visit(StmtFnDef *stmt, Stmt **source)
         err.fail(stmt->getLoc(), "failed to apply simplify pass on func def block");
         return false;
     }
+    fnScopes.pop_back();
     return true;
 }
 bool SimplifyPass::visit(StmtVarDecl *stmt, Stmt **source)
@@ -194,10 +231,13 @@ bool SimplifyPass::visit(StmtCond *stmt, Stmt **source)
             return false;
         }
     }
+    removeDeadBranches(stmt, source);
     return true;
 }
 bool SimplifyPass::visit(StmtFor *stmt, Stmt **source)
 {
+    // for the variables declared in init
+    constScopes.emplace_back();
     if(stmt->getInit() && !visit(stmt->getInit(), &stmt->getInit())) {
         err.fail(stmt->getLoc(), "failed to apply simplify pass on for-loop init");
         return false;
@@ -216,6 +256,8 @@ bool SimplifyPass::visit(StmtFor *stmt, Stmt **source)
         return false;
     }
     if(!defers.popLoop(stmt->getLoc())) return false;
+    constScopes.pop_back();
+    removeDeadLoop(stmt, source);
     return true;
 }
 bool SimplifyPass::visit(StmtRetYield *stmt, Stmt **source)
@@ -41,7 +41,7 @@ StmtBlock::StmtBlock(ModuleLoc loc, Vector<Stmt *> &&stmts, bool istop)
     : Stmt(BLOCK, loc), stmts(std::move(stmts)), istop(istop), shouldunload(true)
 {}
 StmtBlock::~StmtBlock() {}
-StmtBlock *StmtBlock::create(ManagedList &allocator, ModuleLoc loc, Vector<Stmt *> &&stmts,
+StmtBlock *StmtBlock::create(ManagedArena &allocator, ModuleLoc loc, Vector<Stmt *> &&stmts,
                              bool istop)
 {
     return allocator.alloc<StmtBlock>(loc, std::move(stmts), istop);
@@ -82,22 +82,22 @@ StmtSimple::StmtSimple(ModuleLoc loc, lex::TokType tokType, double val)
 {}
 
 StmtSimple::~StmtSimple() {}
-StmtSimple *StmtSimple::create(ManagedList &allocator, ModuleLoc loc, lex::TokType tokType,
+StmtSimple *StmtSimple::create(ManagedArena &allocator, ModuleLoc loc, lex::TokType tokType,
                                String &&val)
 {
     return allocator.alloc<StmtSimple>(loc, tokType, std::move(val));
 }
-StmtSimple *StmtSimple::create(ManagedList &allocator, ModuleLoc loc, lex::TokType tokType,
+StmtSimple *StmtSimple::create(ManagedArena &allocator, ModuleLoc loc, lex::TokType tokType,
                                StringRef val)
 {
     return allocator.alloc<StmtSimple>(loc, tokType, val);
 }
-StmtSimple *StmtSimple::create(ManagedList &allocator, ModuleLoc loc, lex::TokType tokType,
+StmtSimple *StmtSimple::create(ManagedArena &allocator, ModuleLoc loc, lex::TokType tokType,
                                int64_t val)
 {
     return allocator.alloc<StmtSimple>(loc, tokType, val);
 }
-StmtSimple *StmtSimple::create(ManagedList &allocator, ModuleLoc loc, lex::TokType tokType,
+StmtSimple *StmtSimple::create(ManagedArena &allocator, ModuleLoc loc, lex::TokType tokType,
                                double val)
 {
     return allocator.alloc<StmtSimple>(loc, tokType, val);
@@ -125,7 +125,7 @@ StmtFnArgs::StmtFnArgs(ModuleLoc loc, Vector<Stmt *> &&args, Vector<bool> &&unpa
     : Stmt(FNARGS, loc), args(args), unpackVector(unpackVector)
 {}
 StmtFnArgs::~StmtFnArgs() {}
-StmtFnArgs *StmtFnArgs::create(ManagedList &allocator, ModuleLoc loc, Vector<Stmt *> &&args,
+StmtFnArgs *StmtFnArgs::create(ManagedArena &allocator, ModuleLoc loc, Vector<Stmt *> &&args,
                                Vector<bool> &&unpackVector)
 {
     return allocator.alloc<StmtFnArgs>(loc, std::move(args), std::move(unpackVector));
@@ -155,7 +155,7 @@ StmtExpr::StmtExpr(ModuleLoc loc, Stmt *lhs, lex::TokType oper, Stmt *rhs)
     : Stmt(EXPR, loc), lhs(lhs), oper(oper), rhs(rhs)
 {}
 StmtExpr::~StmtExpr() {}
-StmtExpr *StmtExpr::create(ManagedList &allocator, ModuleLoc loc, Stmt *lhs, lex::TokType oper,
+StmtExpr *StmtExpr::create(ManagedArena &allocator, ModuleLoc loc, Stmt *lhs, lex::TokType oper,
                            Stmt *rhs)
 {
     return allocator.alloc<StmtExpr>(loc, lhs, oper, rhs);
@@ -193,7 +193,7 @@ StmtVar::StmtVar(ModuleLoc loc, StringRef name, Stmt *in, Stmt *val, bool isarg)
     : Stmt(VAR, loc), name(name), doc(""), in(in), val(val), isarg(isarg)
 {}
 StmtVar::~StmtVar() {}
-StmtVar *StmtVar::create(ManagedList &allocator, ModuleLoc loc, StringRef name, Stmt *in, Stmt *val,
+StmtVar *StmtVar::create(ManagedArena &allocator, ModuleLoc loc, StringRef name, Stmt *in, Stmt *val,
                          bool isarg)
 {
     return allocator.alloc<StmtVar>(loc, name, in, val, isarg);
@@ -232,7 +232,7 @@ StmtFnSig::StmtFnSig(ModuleLoc loc, const Vector<StmtVar *> &args, StmtSimple *k
     : Stmt(FNSIG, loc), args(args), kwarg(kwarg), vaarg(vaarg), createstack(createstack)
 {}
 StmtFnSig::~StmtFnSig() {}
-StmtFnSig *StmtFnSig::create(ManagedList &allocator, ModuleLoc loc, const Vector<StmtVar *> &args,
+StmtFnSig *StmtFnSig::create(ManagedArena &allocator, ModuleLoc loc, const Vector<StmtVar *> &args,
                              StmtSimple *kwarg, StmtSimple *vaarg, bool createstack)
 {
     return allocator.alloc<StmtFnSig>(loc, args, kwarg, vaarg, createstack);
@@ -271,7 +271,7 @@ StmtFnDef::StmtFnDef(ModuleLoc loc, StmtFnSig *sig, StmtBlock *blk)
     : Stmt(FNDEF, loc), sig(sig), blk(blk)
 {}
 StmtFnDef::~StmtFnDef() {}
-StmtFnDef *StmtFnDef::create(ManagedList &allocator, ModuleLoc loc, StmtFnSig *sig, StmtBlock *blk)
+StmtFnDef *StmtFnDef::create(ManagedArena &allocator, ModuleLoc loc, StmtFnSig *sig, StmtBlock *blk)
 {
     return allocator.alloc<StmtFnDef>(loc, sig, blk);
 }
@@ -293,7 +293,7 @@ StmtVarDecl::StmtVarDecl(ModuleLoc loc, const Vector<StmtVar *> &decls)
     : Stmt(VARDECL, loc), decls(decls)
 {}
 StmtVarDecl::~StmtVarDecl() {}
-StmtVarDecl *StmtVarDecl::create(ManagedList &allocator, ModuleLoc loc,
+StmtVarDecl *StmtVarDecl::create(ManagedArena &allocator, ModuleLoc loc,
                                  const Vector<StmtVar *> &decls)
 {
     return allocator.alloc<StmtVarDecl>(loc, decls);
@@ -317,7 +317,7 @@ Conditional::~Conditional() {}
 StmtCond::StmtCond(ModuleLoc loc, const Vector<Conditional> &conds) : Stmt(COND, loc), conds(conds)
 {}
 StmtCond::~StmtCond() {}
-StmtCond *StmtCond::create(ManagedList &allocator, ModuleLoc loc, const Vector<Conditional> &conds)
+StmtCond *StmtCond::create(ManagedArena &allocator, ModuleLoc loc, const Vector<Conditional> &conds)
 {
     return allocator.alloc<StmtCond>(loc, conds);
 }
@@ -352,7 +352,7 @@ StmtFor::StmtFor(ModuleLoc loc, Stmt *init, Stmt *cond, Stmt *incr, StmtBlock *b
     : Stmt(FOR, loc), init(init), cond(cond), incr(incr), blk(blk)
 {}
 StmtFor::~StmtFor() {}
-StmtFor *StmtFor::create(ManagedList &allocator, ModuleLoc loc, Stmt *init, Stmt *cond, Stmt *incr,
+StmtFor *StmtFor::create(ManagedArena &allocator, ModuleLoc loc, Stmt *init, Stmt *cond, Stmt *incr,
                          StmtBlock *blk)
 {
     return allocator.alloc<StmtFor>(loc, init, cond, incr, blk);
@@ -397,7 +397,7 @@ StmtRetYield::StmtRetYield(ModuleLoc loc, Stmt *val, bool yield)
     : Stmt(RET, loc), val(val), yield(yield)
 {}
 StmtRetYield::~StmtRetYield() {}
-StmtRetYield *StmtRetYield::create(ManagedList &allocator, ModuleLoc loc, Stmt *val, bool yield)
+StmtRetYield *StmtRetYield::create(ManagedArena &allocator, ModuleLoc loc, Stmt *val, bool yield)
 {
     return allocator.alloc<StmtRetYield>(loc, val, yield);
 }
@@ -420,7 +420,7 @@ void StmtRetYield::disp(bool hasNext)
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 
 StmtContinue::StmtContinue(ModuleLoc loc) : Stmt(CONTINUE, loc) {}
-StmtContinue *StmtContinue::create(ManagedList &allocator, ModuleLoc loc)
+StmtContinue *StmtContinue::create(ManagedArena &allocator, ModuleLoc loc)
 {
     return allocator.alloc<StmtContinue>(loc);
 }
@@ -437,7 +437,7 @@ void StmtContinue::disp(bool hasNext)
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 
 StmtBreak::StmtBreak(ModuleLoc loc) : Stmt(BREAK, loc) {}
-StmtBreak *StmtBreak::create(ManagedList &allocator, ModuleLoc loc)
+StmtBreak *StmtBreak::create(ManagedArena &allocator, ModuleLoc loc)
 {
     return allocator.alloc<StmtBreak>(loc);
 }
@@ -455,7 +455,7 @@ void StmtBreak::disp(bool hasNext)
 
 StmtDefer::StmtDefer(ModuleLoc loc, Stmt *val) : Stmt(DEFER, loc), val(val) {}
 StmtDefer::~StmtDefer() {}
-StmtDefer *StmtDefer::create(ManagedList &allocator, ModuleLoc loc, Stmt *val)
+StmtDefer *StmtDefer::create(ManagedArena &allocator, ModuleLoc loc, Stmt *val)
 {
     return allocator.alloc<StmtDefer>(loc, val);
 }
@@ -1,6 +1,7 @@
 #include "Utils.hpp"
 
 #include "File.hpp"
+#include "SIMD.hpp"
 
 #if defined(FER_OS_WINDOWS)
 #include <codecvt>
@@ -65,14 +66,60 @@ size_t stringCharCount(StringRef str, char ch)
     return count;
 }
 
+uint64_t hash64(StringRef data, uint64_t seed)
+{
+    constexpr uint64_t mul = 0x9e3779b97f4a7c15;
+    uint64_t h             = seed ^ (data.size() * mul);
+    size_t i               = 0;
+    uint64_t w;
+    for(; i + 8 <= data.size(); i += 8) {
+        memcpy(&w, data.data() + i, 8);
+        h = (h ^ w) * mul;
+        h ^= h >> 29;
+    }
+    w = 0;
+    if(i < data.size()) memcpy(&w, data.data() + i, data.size() - i);
+    h = (h ^ w) * mul;
+    h ^= h >> 32;
+    return h;
+}
+
 void stringReplace(String &str, StringRef from, StringRef to)
 {
-    auto &&pos = str.find(from);
-    while(pos != String::npos) {
-        str.replace(pos, from.length(), to);
-        // easy to forget to add to.length()
-        pos = str.find(from, pos + to.length());
+    if(from.empty() || simd::find(str, from) == String::npos) return;
+    str = stringReplaceCopy(str, from, to);
+}
+
+String stringReplaceCopy(StringRef str, StringRef from, StringRef to)
+{
+    String res(str);
+    if(from.empty()) return res;
+    if(from.size() == to.size()) {
+        for(size_t pos = simd::find(str, from); pos != String::npos;
+            pos       = simd::find(str, from, pos + from.size()))
+        {
+            memcpy(&res[pos], to.data(), to.size());
+        }
+        return res;
+    }
+    Vector<size_t> positions;
+    for(size_t pos = simd::find(str, from); pos != String::npos;
+        pos       = simd::find(str, from, pos + from.size()))
+    {
+        positions.push_back(pos);
+    }
+    if(positions.empty()) return res;
+
+    res.clear();
+    res.reserve(str.size() - positions.size() * from.size() + positions.size() * to.size());
+    size_t start = 0;
+    for(auto pos : positions) {
+        res.append(str.data() + start, pos - start);
+        res += to;
+        start = pos + from.size();
     }
+    res.append(str.data() + start, str.size() - start);
+    return res;
 }
 
 Vector<StringRef> stringDelim(StringRef str, StringRef delim)
@@ -0,0 +1,83 @@
+#include "VM/AllocProfiler.hpp"
+
+#include "Error.hpp"
+#include "VM/VM.hpp"
+
+namespace fer
+{
+
+AllocProfiler::AllocProfiler(size_t sampleBytes)
+    : untilSample(sampleBytes), sampleBytes(sampleBytes ? sampleBytes : 1)
+{}
+AllocProfiler::~AllocProfiler() {}
+
+void AllocProfiler::record(VirtualMachine &vm, ModuleLoc loc, size_t typeId)
+{
+    const Vector<ModuleLoc> &callLocs = vm.getCallLocs();
+    String key;
+    key.reserve((callLocs.size() + 2) * sizeof(uint64_t));
+    ModuleLoc invalid;
+    for(auto &l : callLocs) {
+        if(l.id != invalid.id) key.append((const char *)&l, sizeof(ModuleLoc));
+    }
+    // natives allocate using the location of their call, no point in repeating it
+    if(loc.id != invalid.id && (callLocs.empty() || callLocs.back() != loc)) {
+        key.append((const char *)&loc, sizeof(ModuleLoc));
+    }
+    key.append((const char *)&typeId, sizeof(size_t));
+
+    LockGuard<Mutex> lock(mtx);
+    Site &site = sites[key];
+    ++site.samples;
+    site.bytes += sampleBytes;
+}
+
+void AllocProfiler::dump(VirtualMachine &vm, OStream &os)
+{
+    // ModuleLoc => "path:line"
+    Map<uint64_t, String> frames;
+    auto getFrame = [&](ModuleLoc loc) -> StringRef {
+        uint64_t rawLoc = *(uint64_t *)&loc;
+        auto it         = frames.find(rawLoc);
+        if(it != frames.end()) return it->second;
+        String frame;
+        File *f = err.getFileForId(loc.id);
+        if(!f) {
+            frame = "<unknown>";
+        } else {
+            StringRef data = f->getData();
+            size_t till    = loc.offStart < data.size() ? loc.offStart : data.size();
+            size_t line    = std::count(data.begin(), data.begin() + till, '\n') + 1;
+            frame          = utils::toString(f->getPath(), ":", line);
+        }
+        return frames.insert({rawLoc, std::move(frame)}).first->second;
+    };
+
+    // Sites are keyed by exact locations, but several of them can render to the same path:line
+    // frames (multiple calls on a line), so aggregate on the rendered stack.
+    StringMap<size_t> folded;
+    LockGuard<Mutex> lock(mtx);
+    for(auto &s : sites) {
+        StringRef key = s.first;
+        size_t typeId = *(size_t *)(key.data() + key.size() - sizeof(size_t));
+        key.remove_suffix(sizeof(size_t));
+        String stack;
+        for(size_t i = 0; i < key.size(); i += sizeof(ModuleLoc)) {
+            stack += getFrame(*(ModuleLoc *)(key.data() + i));
+            stack += ";";
+        }
+        stack += vm.getTypeName(typeId);
+        folded[stack] += s.second.bytes;
+    }
+    for(auto &f : folded) os << f.first << " " << f.second << "\n";
+}
+
+bool AllocProfiler::dump(VirtualMachine &vm, const char *path)
+{
+    OFStream f(path);
+    if(!f) return false;
+    dump(vm, f);
+    return true;
+}
+
+} // namespace fer
@@ -0,0 +1,296 @@
+#include "VM/Bundle.hpp"
+
+#include "Logger.hpp"
+
+namespace fer
+{
+
+// Layout of a bundle file (native byte order, like the bytecode files):
+//   BundleHeader | BundleModule[moduleCount] | BundleDll[dllCount] | BundleLink[linkCount] |
+//   data[dataBytes]
+// All strings (paths, sources, bytecode files) are stored in the data section. Bytecode files are 8
+// byte aligned in it so that they can be used directly from the mapping.
+// The first module is the prelude.
+
+static constexpr char BUNDLE_MAGIC[4] = {'F', 'E', 'R', 'A'};
+
+struct BundleHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint64_t buildId;
+    uint32_t moduleCount;
+    uint32_t dllCount;
+    uint32_t linkCount;
+    uint32_t mainModule;
+    uint64_t dataBytes;
+};
+struct BundleStr
+{
+    uint64_t offset; // in data section
+    uint64_t size;
+};
+struct BundleModule
+{
+    BundleStr path;
+    BundleStr source;
+    BundleStr bytecode;
+};
+struct BundleDll
+{
+    BundleStr path;
+    uint64_t size;
+    int64_t mtime;
+    uint64_t hash; // of the contents
+};
+struct BundleLink
+{
+    BundleStr srcPath;
+    BundleStr name;
+    BundleStr target;
+    uint64_t isImport;
+};
+
+static_assert(sizeof(BundleHeader) == 40 && sizeof(BundleModule) == 48 &&
+              sizeof(BundleDll) == 40 && sizeof(BundleLink) == 56);
+
+static bool hashFile(const char *path, uint64_t &hash)
+{
+    MappedFile file;
+    if(!file.map(path)) return false;
+    hash = utils::hash64(file.getData());
+    return true;
+}
+
+static bool getFileInfo(const char *path, Bundle::Dll &info)
+{
+    std::error_code ec;
+    info.size = fs::file_size(path, ec);
+    if(ec) return false;
+    info.mtime = fs::last_write_time(path, ec).time_since_epoch().count();
+    return !ec;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////// Bundle /////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+Bundle::Bundle() {}
+
+Status<bool> Bundle::open(const char *path)
+{
+    if(!mapping.map(path)) return Status<bool>(false, "failed to read bundle: ", path);
+    StringRef file = mapping.getData();
+    if(file.size() < sizeof(BundleHeader)) {
+        return Status<bool>(false, "not a feral bundle: ", path);
+    }
+    const BundleHeader *hdr = (const BundleHeader *)file.data();
+    if(memcmp(hdr->magic, BUNDLE_MAGIC, sizeof(BUNDLE_MAGIC)) != 0) {
+        return Status<bool>(false, "not a feral bundle: ", path);
+    }
+    if(hdr->version != BUNDLE_FORMAT_VERSION) {
+        return Status<bool>(false, "unsupported bundle version ", (size_t)hdr->version,
+                            " (expected: ", (size_t)BUNDLE_FORMAT_VERSION, "): ", path);
+    }
+    // The bytecode of the modules is rejected by Bytecode::read() in this case, and the modules
+    // are compiled from their bundled sources instead.
+    if(hdr->buildId != Bytecode::getBuildId()) {
+        LOG_INFO("bundle was created by a different build of feral, recompiling its modules: ",
+                 path);
+    }
+    // the counts are 32 bit, so this cannot overflow
+    uint64_t tablesSize = sizeof(BundleHeader) + hdr->moduleCount * sizeof(BundleModule) +
+                          hdr->dllCount * sizeof(BundleDll) + hdr->linkCount * sizeof(BundleLink);
+    if(hdr->moduleCount == 0 || hdr->mainModule >= hdr->moduleCount ||
+       tablesSize > file.size() || file.size() - tablesSize != hdr->dataBytes)
+    {
+        return Status<bool>(false, "corrupted bundle: ", path);
+    }
+    const BundleModule *mods      = (const BundleModule *)(hdr + 1);
+    const BundleDll *dllEntries   = (const BundleDll *)(mods + hdr->moduleCount);
+    const BundleLink *linkEntries = (const BundleLink *)(dllEntries + hdr->dllCount);
+    StringRef data                = file.substr(tablesSize);
+    bool valid                    = true;
+    auto getStr                   = [&](const BundleStr &str) -> StringRef {
+        if(str.offset > data.size() || str.size > data.size() - str.offset) {
+            valid = false;
+            return {};
+        }
+        return data.substr(str.offset, str.size);
+    };
+
+    for(size_t i = 0; i < hdr->moduleCount; ++i) {
+        Module mod{getStr(mods[i].path), getStr(mods[i].source), getStr(mods[i].bytecode)};
+        modules.insert({String(mod.path), mod});
+        if(i == 0) preludePath = mod.path;
+        if(i == hdr->mainModule) mainPath = mod.path;
+    }
+    for(size_t i = 0; i < hdr->dllCount; ++i) {
+        const BundleDll &d = dllEntries[i];
+        dlls.insert({String(getStr(d.path)), {d.size, d.mtime, d.hash}});
+    }
+    for(size_t i = 0; i < hdr->linkCount; ++i) {
+        const BundleLink &l = linkEntries[i];
+        links.insert(
+            {getLinkKey(getStr(l.srcPath), getStr(l.name), l.isImport), getStr(l.target)});
+    }
+    if(!valid) {
+        modules.clear();
+        dlls.clear();
+        links.clear();
+        return Status<bool>(false, "corrupted bundle: ", path);
+    }
+    return Status<bool>(true);
+}
+
+const Bundle::Module *Bundle::getModule(StringRef path) const
+{
+    auto loc = modules.find(path);
+    if(loc == modules.end()) return nullptr;
+    return &loc->second;
+}
+
+bool Bundle::resolve(StringRef srcPath, StringRef name, bool isImport, String &result) const
+{
+    auto loc = links.find(getLinkKey(srcPath, name, isImport));
+    if(loc == links.end()) return false;
+    result = loc->second;
+    return true;
+}
+
+bool Bundle::verifyDll(StringRef path)
+{
+    auto loc = dlls.find(path);
+    if(loc == dlls.end()) return true;
+    String pathStr(path);
+    if(verifiedDlls.contains(pathStr)) return true;
+    // The contents are hashed only if the file times differ (like when the file was copied).
+    Dll info;
+    if(!getFileInfo(pathStr.c_str(), info) || info.size != loc->second.size) return false;
+    if(info.mtime != loc->second.mtime &&
+       (!hashFile(pathStr.c_str(), info.hash) || info.hash != loc->second.hash))
+    {
+        return false;
+    }
+    verifiedDlls.insert(std::move(pathStr));
+    return true;
+}
+
+String Bundle::getLinkKey(StringRef srcPath, StringRef name, bool isImport)
+{
+    String key;
+    key.reserve(srcPath.size() + name.size() + 2);
+    key += srcPath;
+    key += '\0';
+    key += isImport ? 'i' : 'l';
+    key += name;
+    return key;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////// BundleWriter //////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+void BundleWriter::addModule(StringRef path, StringRef source, const Bytecode &bc)
+{
+    Module &mod = modules.emplace_back();
+    mod.path    = path;
+    mod.source  = source;
+    bc.write(mod.bytecode, source);
+}
+
+Status<bool> BundleWriter::addDll(StringRef path)
+{
+    if(dlls.contains(path)) return Status<bool>(true);
+    String pathStr(path);
+    Bundle::Dll info;
+    if(!getFileInfo(pathStr.c_str(), info) || !hashFile(pathStr.c_str(), info.hash)) {
+        return Status<bool>(false, "failed to read native module: ", path);
+    }
+    dlls.insert({std::move(pathStr), info});
+    return Status<bool>(true);
+}
+
+void BundleWriter::addLink(StringRef srcPath, StringRef name, bool isImport, StringRef target)
+{
+    links.push_back({String(srcPath), String(name), String(target), isImport});
+}
+
+Status<bool> BundleWriter::write(const char *path, StringRef mainPath) const
+{
+    String data;
+    StringMap<BundleStr> strIndices;
+    auto addStr = [&](StringRef str) -> BundleStr {
+        auto loc = strIndices.find(str);
+        if(loc != strIndices.end()) return loc->second;
+        BundleStr res{data.size(), str.size()};
+        data += str;
+        strIndices.insert({String(str), res});
+        return res;
+    };
+    auto addAligned = [&](StringRef str) -> BundleStr {
+        data.append((8 - data.size() % 8) % 8, '\0');
+        BundleStr res{data.size(), str.size()};
+        data += str;
+        return res;
+    };
+
+    BundleHeader hdr;
+    memcpy(hdr.magic, BUNDLE_MAGIC, sizeof(BUNDLE_MAGIC));
+    hdr.version     = BUNDLE_FORMAT_VERSION;
+    hdr.buildId     = Bytecode::getBuildId();
+    hdr.moduleCount = modules.size();
+    hdr.dllCount    = dlls.size();
+    hdr.linkCount   = links.size();
+    hdr.mainModule  = modules.size();
+
+    Vector<BundleModule> mods;
+    Vector<BundleDll> dllEntries;
+    Vector<BundleLink> linkEntries;
+    for(size_t i = 0; i < modules.size(); ++i) {
+        const Module &m = modules[i];
+        if(m.path == mainPath) hdr.mainModule = i;
+        mods.push_back({addStr(m.path), addStr(m.source), addAligned(m.bytecode)});
+    }
+    if(hdr.mainModule == modules.size()) {
+        return Status<bool>(false, "main module is not in the bundle: ", mainPath);
+    }
+    for(auto &d : dlls) {
+        dllEntries.push_back({addStr(d.first), d.second.size, d.second.mtime, d.second.hash});
+    }
+    for(auto &l : links) {
+        linkEntries.push_back(
+            {addStr(l.srcPath), addStr(l.name), addStr(l.target), (uint64_t)l.isImport});
+    }
+    hdr.dataBytes = data.size();
+
+    // Like the bytecode files, write to a temporary file and rename it, so that a running bundle
+    // (which is memory mapped) is never modified.
+    String tmpPath = String(path) + ".tmp";
+    FILE *f        = fopen(tmpPath.c_str(), "wb");
+    if(!f) return Status<bool>(false, "failed to open file for writing: ", tmpPath);
+    bool written = fwrite(&hdr, sizeof(hdr), 1, f) == 1;
+    if(!mods.empty()) {
+        written = written && fwrite(mods.data(), sizeof(BundleModule), mods.size(), f) ==
+                                 mods.size();
+    }
+    if(!dllEntries.empty()) {
+        written = written && fwrite(dllEntries.data(), sizeof(BundleDll), dllEntries.size(), f) ==
+                                 dllEntries.size();
+    }
+    if(!linkEntries.empty()) {
+        written = written && fwrite(linkEntries.data(), sizeof(BundleLink), linkEntries.size(),
+                                    f) == linkEntries.size();
+    }
+    if(!data.empty()) written = written && fwrite(data.data(), data.size(), 1, f) == 1;
+    written = fclose(f) == 0 && written;
+    std::error_code ec;
+    if(written) fs::rename(tmpPath, path, ec);
+    if(!written || ec) {
+        fs::remove(tmpPath, ec);
+        return Status<bool>(false, "failed to write bundle: ", path);
+    }
+    return Status<bool>(true);
+}
+
+} // namespace fer
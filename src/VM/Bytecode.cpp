@@ -1,5 +1,8 @@
 #include "VM/Bytecode.hpp"
 
+#include "BuildId.inl"
+#include "Env.hpp"
+
 #include <iomanip>
 
 namespace fer
@@ -32,20 +35,15 @@ StringRef getOpcodeStr(Opcode opcode)
     case Opcode::ATTR: return "ATTR";
     case Opcode::CALL: return "FNCALL";
     case Opcode::MEM_CALL: return "MEM_FNCALL";
+    case Opcode::ADD_CHAIN: return "ADD_CHAIN";
     default: break;
     }
     return "";
 }
 
-Instruction::Instruction(Opcode opcode, ModuleLoc loc, DataType dtype, String &&data,
-                         String &&comment)
-    : data(std::move(data)), comment(std::move(comment)), loc(loc), index(-1), dtype(dtype),
-      opcode(opcode)
-{}
 Instruction::Instruction(Opcode opcode, ModuleLoc loc, DataType dtype, StringRef data,
-                         String &&comment)
-    : data(String(data)), comment(std::move(comment)), loc(loc), index(-1), dtype(dtype),
-      opcode(opcode)
+                         StringRef comment)
+    : data(data), comment(comment), loc(loc), index(-1), dtype(dtype), opcode(opcode)
 {}
 Instruction::Instruction(Opcode opcode, ModuleLoc loc, int64_t data)
     : data(data), loc(loc), index(-1), dtype(DataType::INT), opcode(opcode)
@@ -112,102 +110,220 @@ String Instruction::dump() const
     return outStr;
 }
 
-bool Instruction::readFromFile(FILE *f, size_t moduleId, Instruction &ins)
+void Bytecode::dump(OStream &os) const
 {
-    fread(&ins.loc, sizeof(ins.loc), 1, f);
-    ins.loc.id = moduleId;
-    fread(&ins.opcode, sizeof(ins.opcode), 1, f);
-    fread(&ins.dtype, sizeof(ins.dtype), 1, f);
-    if(ins.isDataInt()) {
-        int64_t d;
-        fread(&d, sizeof(d), 1, f);
-        ins.data = d;
-    }
-    if(ins.isDataFlt()) {
-        double d;
-        fread(&d, sizeof(d), 1, f);
-        ins.data = d;
-    }
-    if(ins.isDataStr() || ins.isDataIden()) {
-        size_t sz;
-        fread(&sz, sizeof(sz), 1, f);
-        String d(sz, '0');
-        if(sz) fread(d.data(), sizeof(String::value_type), sz, f);
-        ins.data = std::move(d);
-    }
-    if(ins.isDataBool()) {
-        bool d;
-        fread(&d, sizeof(d), 1, f);
-        ins.data = d;
-    }
-    bool hasComm = false;
-    fread(&hasComm, sizeof(hasComm), 1, f);
-    if(hasComm) {
-        size_t sz;
-        fread(&sz, sizeof(sz), 1, f);
-        String d(sz, '0');
-        if(sz) fread(d.data(), sizeof(String::value_type), sz, f);
-        ins.comment = std::move(d);
+    for(size_t idx = 0; idx < code.size(); ++idx) {
+        auto &i = code[idx];
+        os << std::left << std::setw(5) << idx << std::left << std::setw(14);
+        i.dump(os);
+        os << "\n";
     }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////// Bytecode File //////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Layout of a bytecode file (native byte order, since the files are only a local cache):
+//   FileHeader | FileInstr[instrCount] | FileString[strCount] | string bytes[strBytes]
+// The string table is deduplicated, and the checksum covers everything after the header.
+
+static constexpr char BYTECODE_MAGIC[4] = {'F', 'E', 'R', 'B'};
+
+struct FileHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint64_t buildId;
+    uint64_t sourceHash;
+    uint64_t checksum;
+    uint64_t instrCount;
+    uint64_t strCount;
+    uint64_t strBytes;
+};
+// Fixed width instruction
+struct FileInstr
+{
+    uint64_t loc;     // ModuleLoc (see packLoc()), the module id is set when reading
+    uint64_t data;    // int, flt (bits), bool, or index in string table (str, iden)
+    uint32_t comment; // index in string table + 1, 0 if there is no comment
+    uint8_t opcode;
+    uint8_t dtype;
+    uint16_t reserved;
+};
+// ModuleLoc as a 64 bit integer - id in the low 16 bits, followed by offStart and offEnd (24 each).
+static inline uint64_t packLoc(ModuleLoc loc)
+{
+    return (uint64_t)loc.id | (uint64_t)loc.offStart << 16 | (uint64_t)loc.offEnd << 40;
+}
+static inline ModuleLoc unpackLoc(uint64_t loc, ModuleId moduleId)
+{
+    return ModuleLoc(moduleId, (loc >> 16) & 0xFFFFFF, loc >> 40);
+}
+
+struct FileString
+{
+    uint32_t offset; // in string bytes
+    uint32_t size;
+};
+
+static_assert(sizeof(FileHeader) == 56 && sizeof(FileInstr) == 24 && sizeof(FileString) == 8);
+
+bool Bytecode::readFromFile(const char *path, ModuleId moduleId, StringRef source, Bytecode &bc)
+{
+    MappedFile mapping;
+    if(!mapping.map(path)) return false;
+    if(!read(mapping.getData(), moduleId, source, bc)) return false;
+    bc.mapping = std::move(mapping);
     return true;
 }
 
-void Instruction::writeToFile(FILE *f) const
+bool Bytecode::read(StringRef file, ModuleId moduleId, StringRef source, Bytecode &bc)
 {
-    fwrite(&loc, sizeof(loc), 1, f);
-    fwrite(&opcode, sizeof(opcode), 1, f);
-    fwrite(&dtype, sizeof(dtype), 1, f);
-    if(isDataInt()) {
-        int64_t d = getDataInt();
-        fwrite(&d, sizeof(d), 1, f);
-    } else if(isDataFlt()) {
-        double d = getDataFlt();
-        fwrite(&d, sizeof(d), 1, f);
-    } else if(isDataStr() || isDataIden()) {
-        StringRef d = getDataStr();
-        size_t sz   = d.size();
-        fwrite(&sz, sizeof(sz), 1, f);
-        if(sz) fwrite(d.data(), sizeof(StringRef::value_type), sz, f);
-    } else if(isDataBool()) {
-        bool d = getDataBool();
-        fwrite(&d, sizeof(d), 1, f);
+    if(file.size() < sizeof(FileHeader) || (uintptr_t)file.data() % alignof(FileHeader) != 0) {
+        return false;
     }
-    bool hasComm = hasComment();
-    fwrite(&hasComm, sizeof(hasComm), 1, f);
-    if(hasComm) {
-        size_t sz = comment.size();
-        fwrite(&sz, sizeof(sz), 1, f);
-        if(sz) fwrite(comment.data(), sizeof(StringRef::value_type), sz, f);
+    const FileHeader *hdr = (const FileHeader *)file.data();
+    if(memcmp(hdr->magic, BYTECODE_MAGIC, sizeof(BYTECODE_MAGIC)) != 0 ||
+       hdr->version != BYTECODE_FORMAT_VERSION || hdr->buildId != getBuildId() ||
+       hdr->sourceHash != utils::hash64(source))
+    {
+        return false;
     }
+    StringRef body = file.substr(sizeof(FileHeader));
+    if(hdr->instrCount > body.size() / sizeof(FileInstr) ||
+       hdr->strCount > body.size() / sizeof(FileString) || hdr->strBytes > body.size() ||
+       hdr->instrCount * sizeof(FileInstr) + hdr->strCount * sizeof(FileString) + hdr->strBytes !=
+           body.size() ||
+       utils::hash64(body) != hdr->checksum)
+    {
+        return false;
+    }
+    const FileInstr *instrs = (const FileInstr *)body.data();
+    const FileString *strs  = (const FileString *)(instrs + hdr->instrCount);
+    const char *strData     = (const char *)(strs + hdr->strCount);
+    for(size_t i = 0; i < hdr->strCount; ++i) {
+        if((uint64_t)strs[i].offset + strs[i].size > hdr->strBytes) return false;
+    }
+
+    Vector<Instruction> code;
+    code.reserve(hdr->instrCount);
+    for(size_t i = 0; i < hdr->instrCount; ++i) {
+        const FileInstr &fi = instrs[i];
+        if(fi.opcode >= (uint8_t)Opcode::LAST || fi.dtype > (uint8_t)DataType::IDEN ||
+           fi.comment > hdr->strCount)
+        {
+            return false;
+        }
+        ModuleLoc loc  = unpackLoc(fi.loc, moduleId);
+        Opcode opcode  = (Opcode)fi.opcode;
+        DataType dtype = (DataType)fi.dtype;
+        switch(dtype) {
+        case DataType::BOOL: code.emplace_back(opcode, loc, fi.data != 0); break;
+        case DataType::NIL: code.emplace_back(opcode, loc); break;
+        case DataType::INT: code.emplace_back(opcode, loc, (int64_t)fi.data); break;
+        case DataType::FLT: {
+            double d;
+            memcpy(&d, &fi.data, sizeof(d));
+            code.emplace_back(opcode, loc, d);
+            break;
+        }
+        case DataType::STR:
+        case DataType::IDEN: {
+            if(fi.data >= hdr->strCount) return false;
+            const FileString &str = strs[fi.data];
+            code.emplace_back(opcode, loc, dtype, StringRef(strData + str.offset, str.size),
+                              StringRef());
+            break;
+        }
+        }
+        if(fi.comment > 0) {
+            const FileString &str = strs[fi.comment - 1];
+            code.back().setComment(StringRef(strData + str.offset, str.size));
+        }
+    }
+    bc.code = std::move(code);
+    bc.strings.clear();
+    bc.mapping.unmap();
+    return true;
 }
 
-void Bytecode::dump(OStream &os) const
+bool Bytecode::writeToFile(FILE *f, StringRef source) const
 {
-    for(size_t idx = 0; idx < code.size(); ++idx) {
-        auto &i = code[idx];
-        os << std::left << std::setw(5) << idx << std::left << std::setw(14);
-        i.dump(os);
-        os << "\n";
-    }
+    String data;
+    write(data, source);
+    return fwrite(data.data(), data.size(), 1, f) == 1;
 }
 
-bool Bytecode::readFromFile(FILE *f, size_t moduleId, Bytecode &bc)
+void Bytecode::write(String &out, StringRef source) const
 {
-    size_t count;
-    fread(&count, sizeof(count), 1, f);
-    bc.code.reserve(count);
-    for(size_t i = 0; i < count; ++i) {
-        bc.addInstrNil(Opcode::LAST, {});
-        if(!Instruction::readFromFile(f, moduleId, bc.getInstrAt(i))) return false;
+    StringMap<uint32_t> strIndices;
+    Vector<FileString> strs;
+    String strData;
+    auto getStrIdx = [&](StringRef str) -> uint32_t {
+        auto loc = strIndices.find(str);
+        if(loc != strIndices.end()) return loc->second;
+        uint32_t idx = strs.size();
+        strs.push_back({(uint32_t)strData.size(), (uint32_t)str.size()});
+        strData += str;
+        strIndices.insert({String(str), idx});
+        return idx;
+    };
+
+    Vector<FileInstr> instrs(code.size());
+    for(size_t i = 0; i < code.size(); ++i) {
+        const Instruction &ins = code[i];
+        FileInstr &fi          = instrs[i];
+        fi.loc                 = packLoc(ins.getLoc());
+        fi.opcode = (uint8_t)ins.getOpcode();
+        fi.dtype  = (uint8_t)ins.getDataType();
+        if(ins.isDataInt()) {
+            fi.data = ins.getDataInt();
+        } else if(ins.isDataFlt()) {
+            double d = ins.getDataFlt();
+            memcpy(&fi.data, &d, sizeof(d));
+        } else if(ins.isDataStr() || ins.isDataIden()) {
+            fi.data = getStrIdx(ins.getDataStr());
+        } else if(ins.isDataBool()) {
+            fi.data = ins.getDataBool();
+        }
+        if(ins.hasComment()) fi.comment = getStrIdx(ins.getComment()) + 1;
     }
-    return true;
+
+    String body;
+    body.reserve(instrs.size() * sizeof(FileInstr) + strs.size() * sizeof(FileString) +
+                 strData.size());
+    body.append((const char *)instrs.data(), instrs.size() * sizeof(FileInstr));
+    body.append((const char *)strs.data(), strs.size() * sizeof(FileString));
+    body += strData;
+
+    FileHeader hdr;
+    memcpy(hdr.magic, BYTECODE_MAGIC, sizeof(BYTECODE_MAGIC));
+    hdr.version    = BYTECODE_FORMAT_VERSION;
+    hdr.buildId    = getBuildId();
+    hdr.sourceHash = utils::hash64(source);
+    hdr.checksum   = utils::hash64(body);
+    hdr.instrCount = instrs.size();
+    hdr.strCount   = strs.size();
+    hdr.strBytes   = strData.size();
+
+    out.reserve(out.size() + sizeof(hdr) + body.size());
+    out.append((const char *)&hdr, sizeof(hdr));
+    out += body;
 }
 
-void Bytecode::writeToFile(FILE *f) const
+uint64_t Bytecode::getBuildId()
 {
-    size_t count = code.size();
-    fwrite(&count, sizeof(count), 1, f);
-    for(auto &c : code) { c.writeToFile(f); }
+    static uint64_t buildId = [] {
+        uint64_t h = utils::hash64(PROJECT_VERSION_STR);
+        // Identifies the compiler even for builds from a dirty tree, which can have any changes
+        // for the same commit. It's regenerated on every build (see cmake/BuildId.cmake).
+        h = utils::hash64(SOURCE_HASH, h);
+        h = utils::hash64(BUILD_COMPILER, h);
+        h = utils::hash64(CMAKE_BUILD_TYPE, h);
+        return h;
+    }();
+    return buildId;
 }
 
-} // namespace fer
\ No newline at end of file
+} // namespace fer
@@ -13,6 +13,13 @@ bool loadCommon(VirtualMachine &vm, ModuleLoc loc, Var *modname, bool isImport,
         vm.fail(loc, "expected mod name to be of type string, found: ", vm.getTypeName(modname));
         return false;
     }
+    // Programs run from a bundle use the imports resolved when the bundle was created.
+    Bundle *bundle = vm.getBundle();
+    if(bundle && bundle->resolve(vm.getCurrModule()->getPath(), as<VarStr>(modname)->getVal(),
+                                 isImport, result))
+    {
+        return true;
+    }
     Array<Var *, 3> tmpArgs{nullptr, modname, isImport ? vm.getTrue() : vm.getFalse()};
     Var *ret = nullptr;
     for(auto &callable : vm.getModuleFinders()->getVal()) {
@@ -43,22 +50,78 @@ bool loadCommon(VirtualMachine &vm, ModuleLoc loc, Var *modname, bool isImport,
     return true;
 }
 
+// Imports the module at file if it's not already imported. Must be called with loadMtx locked.
+static VarModule *importModule(VirtualMachine &vm, ModuleLoc loc, const String &file)
+{
+    VarModule *mod = vm.getModule(file);
+    if(mod) return mod;
+    int res = vm.compileAndRun(loc, file.c_str(), &mod);
+    if(res != 0 && !vm.isExitCalled()) {
+        vm.decVarRef(mod);
+        vm.fail(loc, "could not import: '", file, "', look at error above (exit code: ", res, ")");
+        return nullptr;
+    }
+    vm.decVarRef(mod, false);
+    vm.addGlobal(file, "", mod);
+    return mod;
+}
+
+// Changes whenever the module dirs or finders change, since the imports may then be resolved to
+// different modules.
+static size_t getModuleSearchHash(VirtualMachine &vm)
+{
+    size_t h     = 0;
+    auto combine = [&h](size_t v) { h ^= v + 0x9e3779b97f4a7c15 + (h << 6) + (h >> 2); };
+    for(auto &dir : vm.getModuleDirs()->getVal()) {
+        if(dir->is<VarPath>()) combine(std::hash<StringRef>{}(as<VarPath>(dir)->toStr()));
+        else combine((size_t)dir);
+    }
+    for(auto &finder : vm.getModuleFinders()->getVal()) combine((size_t)finder);
+    return h;
+}
+
+bool loadLazyModule(VirtualMachine &vm, ModuleLoc loc, VarModule *mod)
+{
+    if(!mod->isLazy()) return true;
+    LockGuard<RecursiveMutex> _(loadMtx);
+    // another thread may have imported it in the meantime
+    if(!mod->isLazy()) return true;
+    VarModule *imported = importModule(vm, loc, String(mod->getPath()));
+    if(!imported) return false;
+    mod->setImported(vm, imported);
+    return true;
+}
+
 FERAL_FUNC_DEF(loadFile)
 {
+    // Fast path (no locking) for modules which have already been imported from this module
+    StringRef srcPath = vm.getCurrModule()->getPath();
+    size_t searchHash = getModuleSearchHash(vm);
+    if(args[1]->is<VarStr>()) {
+        VarModule *mod =
+            vm.getImportCache().get(as<VarStr>(args[1])->getVal(), srcPath, searchHash);
+        if(mod) return mod;
+    }
+    static bool lazyByDefault = vm.getArgParser().has("lazy");
+    bool lazy                 = lazyByDefault;
+    Var *lazyVar              = assnArgs->getAttr("lazy");
+    if(lazyVar) {
+        EXPECT(VarBool, lazyVar, "lazy");
+        lazy = as<VarBool>(lazyVar)->getVal();
+    }
     LockGuard<RecursiveMutex> _(loadMtx);
     String file;
     if(!loadCommon(vm, loc, args[1], true, file)) return nullptr;
     VarModule *mod = vm.getModule(file);
-    if(!mod) {
-        int res = vm.compileAndRun(loc, file.c_str(), &mod);
-        if(res != 0 && !vm.isExitCalled()) {
-            vm.decVarRef(mod);
-            vm.fail(args[1]->getLoc(), "could not import: '", file,
-                    "', look at error above (exit code: ", res, ")");
-            return nullptr;
-        }
-        vm.decVarRef(mod, false);
-        vm.addGlobal(file, "", mod);
+    // The module is imported on first access of its attributes, unless it's already imported.
+    if(!mod && lazy) return vm.makeVar<VarModule>(loc, file);
+    if(!mod && !(mod = importModule(vm, args[1]->getLoc(), file))) return nullptr;
+    // only the modules held by globals are guaranteed to live till the end
+    // The module search (.modulePaths files) and the imported module may have changed the module
+    // dirs, so the hash is computed again.
+    if(vm.getGlobal(file) == mod) {
+        vm.getImportCache().set(as<VarStr>(args[1])->getVal(), srcPath, getModuleSearchHash(vm),
+                                mod);
     }
     return mod;
 }
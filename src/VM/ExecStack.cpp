@@ -5,10 +5,12 @@
 namespace fer
 {
 
-ExecStack::ExecStack(VirtualMachine &vm) : vm(vm) { stack.reserve(10); }
+ExecStack::ExecStack(VirtualMachine &vm) : vm(vm), pinnedTill(0) { stack.reserve(10); }
 ExecStack::~ExecStack()
 {
-    for(auto &e : stack) vm.decVarRef(e);
+    for(auto &e : stack) {
+        if(!isBorrowed(e)) vm.decVarRef(e);
+    }
 }
 
 void ExecStack::push(Var *val, bool iref)
@@ -17,22 +19,44 @@ void ExecStack::push(Var *val, bool iref)
     stack.push_back(val);
 }
 Var *ExecStack::pop(bool dref)
+{
+    bool counted = false;
+    Var *back    = popSlot(counted);
+    if(!back) return nullptr;
+    if(counted && dref) vm.decVarRef(back);
+    else if(!counted && !dref) vm.incVarRef(back);
+    return back;
+}
+Var *ExecStack::popSlot(bool &counted)
 {
     if(stack.empty()) return nullptr;
     Var *back = stack.back();
     stack.pop_back();
-    if(dref) vm.decVarRef(back);
-    return back;
+    if(pinnedTill > stack.size()) pinnedTill = stack.size();
+    counted = !isBorrowed(back);
+    return untag(back);
+}
+void ExecStack::popTill(size_t count)
+{
+    while(stack.size() > count) pop();
+}
+void ExecStack::pin()
+{
+    for(size_t i = pinnedTill; i < stack.size(); ++i) {
+        if(!isBorrowed(stack[i])) continue;
+        stack[i] = vm.incVarRef(untag(stack[i]));
+    }
+    pinnedTill = stack.size();
 }
 
 String ExecStack::dump(VirtualMachine *vm)
 {
     String outStr;
     for(auto &e : stack) {
-        e->dump(outStr, vm);
+        untag(e)->dump(outStr, vm);
         outStr += " -- ";
     }
     return outStr;
 }
 
-} // namespace fer
\ No newline at end of file
+} // namespace fer
@@ -16,8 +16,10 @@ Var *loadModule(VirtualMachine &vm, ModuleLoc loc, Span<Var *> args, VarMap *ass
 //////////////////////////////////////////////////////////////////////////////////////////////////
 
 GlobalState::GlobalState(args::ArgParser &argparser, ParseSourceFn parseSourceFn)
-    : mem("VM::Main"), managedAllocator(mem, "VM::ManagedAllocator"), argparser(argparser),
-      parseSourceFn(parseSourceFn), vmCount(0), recurseMax(DEFAULT_MAX_RECURSE_COUNT)
+    : mem("VM::Main", DEFAULT_POOL_SIZE, argparser.has("memstats")),
+      managedAllocator(mem, "VM::ManagedAllocator"), argparser(argparser),
+      parseSourceFn(parseSourceFn), vmCount(0), importCache(mem), bundle(nullptr),
+      recurseMax(DEFAULT_MAX_RECURSE_COUNT), allocProfiler(nullptr)
 {}
 GlobalState::~GlobalState() {}
 
@@ -31,6 +33,26 @@ bool GlobalState::init(VirtualMachine &vm)
 
     prelude = "prelude/prelude";
 
+    Path srcFile(argparser.getValue("source"));
+    if(srcFile.extension() == Bundle::getExtension()) {
+        bundle                 = mem.allocInit<Bundle>();
+        Status<bool> bundleRes = bundle->open(srcFile.string().c_str());
+        if(!bundleRes.getCode()) {
+            err.fail({}, bundleRes.getMsg());
+            return false;
+        }
+        prelude = bundle->getPreludePath();
+    }
+
+    if(argparser.has("allocprof")) {
+        size_t sampleBytes = DEFAULT_ALLOC_SAMPLE_BYTES;
+        if(argparser.has("allocrate")) {
+            String rate(argparser.getValue("allocrate"));
+            sampleBytes = std::strtoull(rate.c_str(), nullptr, 10);
+        }
+        allocProfiler = mem.allocInit<AllocProfiler>(sampleBytes);
+    }
+
     basicErrHandler = vm.incVarRef(vm.makeFn({}, basicErrorHandler));
     globals         = vm.incVarRef(vm.makeVar<VarMap>({}, true, false));
     moduleDirs      = vm.incVarRef(vm.makeVar<VarVec>({}, 2, false));
@@ -98,6 +120,7 @@ bool GlobalState::init(VirtualMachine &vm)
     vm.addGlobalType<VarStr>({}, "Str", "Builtin type.");
     vm.addGlobalType<VarVec>({}, "Vec", "Builtin type.");
     vm.addGlobalType<VarMap>({}, "Map", "Builtin type.");
+    vm.addGlobalType<VarHashMap>({}, "HashMap", "Builtin type.");
     vm.addGlobalType<VarFn>({}, "Func", "Builtin type.");
     vm.addGlobalType<VarClosure>({}, "Closure", "Builtin type.");
     vm.addGlobalType<VarAsync>({}, "Async", "Builtin type.");
@@ -114,9 +137,12 @@ bool GlobalState::init(VirtualMachine &vm)
     vm.addGlobalType<VarError>({}, "Error", "Builtin type.");
     vm.addGlobalType<VarResult>({}, "Result", "Builtin type.");
     vm.addGlobalType<VarBytebuffer>({}, "Bytebuffer", "Builtin type.");
+    vm.addGlobalType<VarStrBuilder>({}, "StrBuilder", "Builtin type.");
+    vm.addGlobalType<VarStrTemplate>({}, "StrTemplate", "Builtin type.");
     vm.addGlobalType<VarIntIterator>({}, "IntIterator", "Builtin type.");
     vm.addGlobalType<VarVecIterator>({}, "VecIterator", "Builtin type.");
     vm.addGlobalType<VarMapIterator>({}, "MapIterator", "Builtin type.");
+    vm.addGlobalType<VarHashMapIterator>({}, "HashMapIterator", "Builtin type.");
     vm.addGlobalType<VarFileIterator>({}, "FileIterator", "Builtin type.");
 
     return true;
@@ -126,6 +152,16 @@ bool GlobalState::deinit(VirtualMachine &vm)
     using namespace std::chrono_literals;
     vm.stopExecution();
     while(vmCount.load() > 0) { std::this_thread::sleep_for(1ms); }
+    importCache.clear();
+    if(allocProfiler) {
+        AllocProfiler *profiler = allocProfiler;
+        allocProfiler           = nullptr;
+        String outPath(argparser.getValue("allocprof"));
+        if(!profiler->dump(vm, outPath.c_str())) {
+            err.fail({}, "failed to write allocation profile to: ", outPath);
+        }
+        mem.freeDeinit(profiler);
+    }
     vm.decVarRef(nil);
     vm.decVarRef(fals);
     vm.decVarRef(tru);
@@ -145,6 +181,9 @@ bool GlobalState::deinit(VirtualMachine &vm)
     remDLLDirectories();
 #endif
 
+    // the bytecode of the modules refers to the bundle's mapping
+    if(bundle) mem.freeDeinit(bundle);
+
     return true;
 }
 
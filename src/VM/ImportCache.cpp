@@ -0,0 +1,71 @@
+#include "VM/ImportCache.hpp"
+
+namespace fer
+{
+
+ImportCache::Entry::Entry(StringRef name, StringRef srcPath, VarModule *mod, size_t searchHash,
+                          size_t hash)
+    : name(name), srcPath(srcPath), mod(mod), searchHash(searchHash), hash(hash)
+{}
+bool ImportCache::Entry::matches(StringRef name, StringRef srcPath, size_t searchHash,
+                                 size_t hash) const
+{
+    return this->hash == hash && this->searchHash == searchHash && this->name == name &&
+           this->srcPath == srcPath;
+}
+
+ImportCache::ImportCache(MemoryManager &mem) : mem(mem), count(0)
+{
+    for(auto &slot : slots) slot.store(nullptr, std::memory_order_relaxed);
+}
+ImportCache::~ImportCache() { clear(); }
+
+size_t ImportCache::getHash(StringRef name, StringRef srcPath, size_t searchHash)
+{
+    size_t h = std::hash<StringRef>{}(name);
+    h ^= std::hash<StringRef>{}(srcPath) + 0x9e3779b97f4a7c15 + (h << 6) + (h >> 2);
+    return h ^ (searchHash + 0x9e3779b97f4a7c15 + (h << 6) + (h >> 2));
+}
+
+VarModule *ImportCache::get(StringRef name, StringRef srcPath, size_t searchHash)
+{
+    size_t hash = getHash(name, srcPath, searchHash);
+    for(size_t i = 0; i < IMPORT_CACHE_SLOTS; ++i) {
+        Entry *e = slots[(hash + i) % IMPORT_CACHE_SLOTS].load(std::memory_order_acquire);
+        if(!e) return nullptr;
+        if(e->matches(name, srcPath, searchHash, hash)) return e->mod;
+    }
+    return nullptr;
+}
+
+void ImportCache::set(StringRef name, StringRef srcPath, size_t searchHash, VarModule *mod)
+{
+    // Keep some slots empty so that the misses terminate quickly.
+    if(count.load(std::memory_order_relaxed) >= IMPORT_CACHE_SLOTS * 3 / 4) return;
+    size_t hash = getHash(name, srcPath, searchHash);
+    Entry *e    = nullptr;
+    for(size_t i = 0; i < IMPORT_CACHE_SLOTS; ++i) {
+        Atomic<Entry *> &slot = slots[(hash + i) % IMPORT_CACHE_SLOTS];
+        Entry *curr           = slot.load(std::memory_order_acquire);
+        if(!curr) {
+            if(!e) e = mem.allocInit<Entry>(name, srcPath, mod, searchHash, hash);
+            if(slot.compare_exchange_strong(curr, e, std::memory_order_acq_rel)) {
+                count.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+        }
+        if(curr->matches(name, srcPath, searchHash, hash)) break;
+    }
+    if(e) mem.freeDeinit(e);
+}
+
+void ImportCache::clear()
+{
+    for(auto &slot : slots) {
+        Entry *e = slot.exchange(nullptr, std::memory_order_acq_rel);
+        if(e) mem.freeDeinit(e);
+    }
+    count.store(0, std::memory_order_relaxed);
+}
+
+} // namespace fer
@@ -16,6 +16,7 @@ namespace fer
 {
 
 Var *loadModule(VirtualMachine &vm, ModuleLoc loc, Span<Var *> args, VarMap *assnArgs);
+bool loadCommon(VirtualMachine &vm, ModuleLoc loc, Var *modname, bool isImport, String &result);
 
 //////////////////////////////////////////////////////////////////////////////////////////////////
 //////////////////////////////////// VirtualMachine //////////////////////////////////////////////
@@ -65,6 +66,12 @@ VirtualMachine::~VirtualMachine()
     }
 }
 
+void VirtualMachine::decFrameVarRef(Var *var)
+{
+    execstack->pin();
+    decVarRef(var);
+}
+
 VirtualMachine *VirtualMachine::createVM(StringRef name, VarFn *errHandler)
 {
     return gs->mem.allocInit<VirtualMachine>(gs, name, errHandler);
@@ -89,11 +96,17 @@ Var *VirtualMachine::runCallable(ModuleLoc loc, StringRef name, Var *callable, S
 
 int VirtualMachine::compileAndRun(ModuleLoc loc, const char *file, VarModule **module)
 {
-    File *f              = gs->managedAllocator.alloc<File>(file, false);
-    Status<bool> readRes = f->read();
-    if(!readRes.getCode()) {
-        err.fail({}, "Failed to read file: ", file, ": ", readRes.getMsg());
-        return 1;
+    File *f                   = nullptr;
+    const Bundle::Module *bmod = gs->bundle ? gs->bundle->getModule(file) : nullptr;
+    if(bmod) {
+        f = gs->managedAllocator.alloc<File>(file, bmod->source);
+    } else {
+        f                    = gs->managedAllocator.alloc<File>(file, false);
+        Status<bool> readRes = f->read();
+        if(!readRes.getCode()) {
+            err.fail({}, "Failed to read file: ", file, ": ", readRes.getMsg());
+            return 1;
+        }
     }
 
     VarModule *tmpMod = makeModule(loc, f, false, false);
@@ -117,6 +130,70 @@ int VirtualMachine::compileAndRun(ModuleLoc loc, const char *file, VarModule **m
     return res;
 }
 
+bool VirtualMachine::createBundle(ModuleLoc loc, const Path &mainFile, const char *outFile)
+{
+    BundleWriter writer;
+    String mainPath = fs::absolute(mainFile).string();
+    // modules are added in the order they are found, starting with the prelude
+    Vector<String> pending{gs->prelude, mainPath};
+    Set<String> found(pending.begin(), pending.end());
+    for(size_t i = 0; i < pending.size(); ++i) {
+        String path          = pending[i];
+        File *f              = gs->managedAllocator.alloc<File>(path.c_str(), false);
+        Status<bool> readRes = f->read();
+        if(!readRes.getCode()) {
+            fail(loc, "failed to read file: ", path, ": ", readRes.getMsg());
+            return false;
+        }
+        VarModule *mod = makeModule(loc, f, false, false);
+        if(!mod) {
+            fail(loc, "failed to parse module: ", path);
+            return false;
+        }
+        writer.addModule(path, f->getData(), mod->getBytecode());
+
+        // Module is made current, without executing it, for resolving the relative imports.
+        pushModule(mod);
+        const Vector<Instruction> &code = mod->getBytecode().getBytecode();
+        bool ok                         = true;
+        // import('...') / loadlib('...') => LOAD_DATA <iden>, LOAD_DATA <str>, CALL
+        // With assignment args (like lazy = true), each of them is a pair of LOAD_DATA <value>,
+        // LOAD_DATA <str> before the module name.
+        for(size_t j = 0; ok && j + 2 < code.size(); ++j) {
+            const Instruction &fn = code[j];
+            if(fn.getOpcode() != Opcode::LOAD_DATA || !fn.isDataIden()) continue;
+            bool isImport = fn.getDataStr() == "import";
+            if(!isImport && fn.getDataStr() != "loadlib") continue;
+            size_t callAt = j + 1;
+            while(callAt < code.size() && code[callAt].getOpcode() == Opcode::LOAD_DATA) ++callAt;
+            if(callAt == code.size() || code[callAt].getOpcode() != Opcode::CALL) continue;
+            const Instruction &arg = code[callAt - 1];
+            if((callAt - j - 1) % 2 == 0 || !arg.isDataStr()) continue;
+            VarStr *name = incVarRef(makeVar<VarStr>(arg.getLoc(), arg.getDataStr()));
+            String target;
+            ok = loadCommon(*this, arg.getLoc(), name, isImport, target);
+            decVarRef(name);
+            if(!ok) break;
+            writer.addLink(path, arg.getDataStr(), isImport, target);
+            if(!isImport) {
+                Status<bool> dllRes = writer.addDll(target);
+                if(!(ok = dllRes.getCode())) fail(arg.getLoc(), dllRes.getMsg());
+            } else if(!found.contains(target)) {
+                found.insert(target);
+                pending.push_back(target);
+            }
+        }
+        popModule();
+        if(!ok) return false;
+    }
+    Status<bool> writeRes = writer.write(outFile, mainPath);
+    if(!writeRes.getCode()) {
+        fail(loc, writeRes.getMsg());
+        return false;
+    }
+    return true;
+}
+
 bool VirtualMachine::loadPrelude()
 {
     addGlobal({}, "import", loadFile);
@@ -133,7 +210,7 @@ bool VirtualMachine::loadPrelude()
     const String &currPath = fs::current_path().native().c_str();
 #endif
 
-    if(!findImportIn(gs->moduleDirs, gs->prelude, currPath.c_str())) {
+    if(!gs->bundle && !findImportIn(gs->moduleDirs, gs->prelude, currPath.c_str())) {
         err.fail({}, "Failed to find prelude: ", gs->prelude);
         return 1;
     }
@@ -165,34 +242,35 @@ VarModule *VirtualMachine::makeModule(ModuleLoc loc, File *f, bool exprOnly, boo
         bcPath /= srcPath.relative_path();
         bcPath += ".bc";
     }
-    std::error_code ec;
-    static auto feralTime  = fs::last_write_time(env::getProcPath(), ec);
+    // Whether the bytecode file is usable is decided by its header (source hash and build id), not
+    // by the file times - those are unreliable when files are copied or feral is rebuilt.
     static bool hasNoBCArg = getArgParser().has("nobc");
-    auto bcPathTime        = fs::last_write_time(bcPath, ec);
-    auto filePathTime      = fs::last_write_time(f->getPath(), ec);
-    bool bcFileValid       = bcPathTime > filePathTime && bcPathTime > feralTime && !hasNoBCArg;
+    std::error_code ec;
     Bytecode bc;
     err.addFile(moduleIdCtr, f);
-    if(bcFileValid) {
-        if(!f->isVirtual()) {
-            LOG_INFO("Reading bytecode file: ", bcPath);
 #if defined(FER_OS_WINDOWS)
-            FILE *f = fopen(bcPath.string().c_str(), "rb");
+    String bcPathStr = bcPath.string();
 #else
-            FILE *f = fopen(bcPath.native().c_str(), "rb");
+    const String &bcPathStr = bcPath.native();
 #endif
-            Bytecode::readFromFile(f, moduleIdCtr, bc);
-            fclose(f);
-            LOG_INFO("- Read bytecodes: ", bc.size());
-        }
-    } else {
+    bool bcLoaded              = false;
+    const Bundle::Module *bmod = gs->bundle ? gs->bundle->getModule(f->getPath()) : nullptr;
+    if(bmod) {
+        bcLoaded = Bytecode::read(bmod->bytecode, moduleIdCtr, f->getData(), bc);
+        if(!bcLoaded) LOG_INFO("- Bundled bytecode is invalid or outdated, recompiling source");
+    } else if(!hasNoBCArg && !f->isVirtual()) {
+        LOG_INFO("Reading bytecode file: ", bcPath);
+        bcLoaded = Bytecode::readFromFile(bcPathStr.c_str(), moduleIdCtr, f->getData(), bc);
+        if(bcLoaded) LOG_INFO("- Read bytecodes: ", bc.size());
+        else LOG_INFO("- Bytecode file is invalid or outdated, recompiling source");
+    }
+    if(!bcLoaded) {
         if(!gs->parseSourceFn(*this, bc, moduleIdCtr, f->getPath(), f->getData(), exprOnly)) {
             fail(loc, "failed to parse source: ", f->getPath());
             return nullptr;
         }
-        if(!f->isVirtual()) {
+        if(!bmod && !f->isVirtual()) {
             LOG_INFO("Writing bytecode file: ", bcPath);
-            std::error_code ec;
             fs::create_directories(bcPath.parent_path(), ec);
             if(ec.value()) {
                 LOG_FATAL("failed to create directory for bytecode file: ", bcPath,
@@ -201,22 +279,32 @@ VarModule *VirtualMachine::makeModule(ModuleLoc loc, File *f, bool exprOnly, boo
                      "; error: ", ec.message());
                 return nullptr;
             }
-#if defined(FER_OS_WINDOWS)
-            FILE *f = fopen(bcPath.string().c_str(), "wb");
-#else
-            FILE *f = fopen(bcPath.native().c_str(), "wb");
-#endif
-            if(!f) {
-                LOG_FATAL("failed to write bytecode file: ", bcPath);
-                fail(loc, "failed to write bytecode file: ", bcPath);
+            // Bytecode files are memory mapped when read, so an existing file must never be
+            // overwritten in place (other processes may have it mapped). Instead, write to a
+            // temporary file and rename it over the old one.
+            // The name is unique per process and thread, since feral processes (like the ones
+            // started by utils/testdir.fer) can compile the same module simultaneously.
+            size_t threadId = std::hash<std::thread::id>{}(std::this_thread::get_id());
+            String tmpPath  = bcPathStr + ".tmp" + std::to_string(env::getPid()) + "." +
+                             std::to_string(threadId);
+            FILE *fp = fopen(tmpPath.c_str(), "wb");
+            if(!fp) {
+                LOG_FATAL("failed to write bytecode file: ", tmpPath);
+                fail(loc, "failed to write bytecode file: ", tmpPath);
                 return nullptr;
             }
-            bc.writeToFile(f);
-            fclose(f);
+            bool written = bc.writeToFile(fp, f->getData());
+            written      = fclose(fp) == 0 && written;
+            if(written) fs::rename(tmpPath, bcPath, ec);
+            if(!written || ec) {
+                LOG_WARN("failed to write bytecode file: ", bcPath);
+                fs::remove(tmpPath, ec);
+            }
         }
     }
     VarModule *mod = makeVar<VarModule>(loc, err.getPathForId(moduleIdCtr), std::move(bc),
                                         moduleIdCtr, isVirtual);
+    gs->modulePaths.try_emplace(String(mod->getPath()), mod);
     gs->modules[moduleIdCtr++] = mod;
     return mod;
 }
@@ -230,8 +318,23 @@ void VirtualMachine::popModule()
     VarModule *back = modulestack.back();
     if(!back->isVirtual()) vars->popMod(*this);
     modulestack.pop_back();
-    ModuleId id = back->getModuleId();
-    if(!decVarRef(back)) { gs->modules.erase(id); }
+    // the module is about to be destroyed
+    if(back->getRef() <= 1) removeModule(back);
+    decVarRef(back);
+}
+void VirtualMachine::removeModule(VarModule *mod)
+{
+    LockGuard<RecursiveMutex> globalGuard(gs->mutex);
+    gs->modules.erase(mod->getModuleId());
+    auto loc = gs->modulePaths.find(mod->getPath());
+    if(loc == gs->modulePaths.end() || loc->second != mod) return;
+    gs->modulePaths.erase(loc);
+    // another module may exist for the same path
+    for(auto &it : gs->modules) {
+        if(it.second->getPath() != mod->getPath()) continue;
+        gs->modulePaths.insert({String(it.second->getPath()), it.second});
+        break;
+    }
 }
 
 VarFn *VirtualMachine::makeFn(ModuleLoc loc, const FeralNativeFnDesc &fnObj)
@@ -306,7 +409,11 @@ VarMap *VirtualMachine::getTypeFns(Var *var)
     return loc->second;
 }
 
-void VirtualMachine::setTypeName(size_t _typeid, StringRef name) { gs->typenames[_typeid] = name; }
+void VirtualMachine::setTypeName(size_t _typeid, StringRef name)
+{
+    gs->typenames[_typeid] = name;
+    gs->mem.setTagName(_typeid, name);
+}
 StringRef VirtualMachine::getTypeName(size_t _typeid)
 {
     auto loc = gs->typenames.find(_typeid);
@@ -326,25 +433,18 @@ Var *VirtualMachine::getConst(ModuleLoc loc, const Instruction::Data &d, DataTyp
     case DataType::BOOL: return std::get<bool>(d) ? gs->tru : gs->fals;
     case DataType::INT: return makeVar<VarInt>(loc, std::get<int64_t>(d));
     case DataType::FLT: return makeVar<VarFlt>(loc, std::get<double>(d));
-    case DataType::STR: return makeVar<VarStr>(loc, std::get<String>(d));
+    case DataType::STR: return makeVar<VarStr>(loc, std::get<StringRef>(d));
     default: err.fail(loc, "internal error: invalid data type encountered");
     }
     return nullptr;
 }
 
-bool VirtualMachine::hasModule(StringRef path)
-{
-    for(auto &it : gs->modules) {
-        if(it.second->getPath() == path) return true;
-    }
-    return false;
-}
+bool VirtualMachine::hasModule(StringRef path) { return getModule(path) != nullptr; }
 VarModule *VirtualMachine::getModule(StringRef path)
 {
-    for(auto &it : gs->modules) {
-        if(it.second->getPath() == path) return it.second;
-    }
-    return nullptr;
+    LockGuard<RecursiveMutex> globalGuard(gs->mutex);
+    auto loc = gs->modulePaths.find(path);
+    return loc == gs->modulePaths.end() ? nullptr : loc->second;
 }
 
 void VirtualMachine::tryAddModulePathsFromDir(String dir)
@@ -448,6 +548,11 @@ Var *VirtualMachine::loadDll(ModuleLoc loc, const String &dllpath, StringRef dll
     DynLib &dlibs = DynLib::getInstance();
     if(dlibs.exists(dllpath)) return getNil();
 
+    if(gs->bundle && !gs->bundle->verifyDll(dllpath)) {
+        fail(loc, "module file: ", dllpath, " has changed since the bundle was created");
+        return nullptr;
+    }
+
     if(!dlibs.load(dllpath.c_str())) {
         fail(loc, "unable to load module file: ", dllpath);
         return nullptr;
@@ -480,6 +585,9 @@ Var *VirtualMachine::callVar(ModuleLoc loc, StringRef name, Span<Var *> args, Va
     bool memcall = args[0] != nullptr;
     Var *fn      = nullptr;
     if(memcall) {
+        if(args[0]->is<VarModule>() && !as<VarModule>(args[0])->load(*this, loc)) {
+            return nullptr;
+        }
         if(args[0]->isAttrBased()) fn = args[0]->getAttr(name);
         if(!fn) fn = getTypeFn(args[0], name);
     } else {
@@ -518,6 +626,16 @@ Var *VirtualMachine::callVar(ModuleLoc loc, StringRef name, Var *callable, Span<
 }
 
 Var *VirtualMachine::eval(ModuleLoc loc, StringRef code, bool isExpr)
+{
+    VarModule *mod = compileEval(loc, code, isExpr);
+    if(!mod) return nullptr;
+    incVarRef(mod);
+    Var *res = evalModule(loc, mod);
+    releaseEvalModule(mod);
+    return res;
+}
+
+VarModule *VirtualMachine::compileEval(ModuleLoc loc, StringRef code, bool isExpr)
 {
     static ModuleId evalCtr = 0;
 
@@ -532,6 +650,13 @@ Var *VirtualMachine::eval(ModuleLoc loc, StringRef code, bool isExpr)
         fail(loc, "Failed to parse eval code: ", code);
         return nullptr;
     }
+    return mod;
+}
+
+Var *VirtualMachine::evalModule(ModuleLoc loc, VarModule *mod)
+{
+    // the caller's args are still on the exec stack
+    size_t stackBase = execstack->size();
     pushModule(mod);
     Var *tmpRet = nullptr;
     int ec      = execute(tmpRet, nullptr);
@@ -543,7 +668,13 @@ Var *VirtualMachine::eval(ModuleLoc loc, StringRef code, bool isExpr)
         return nullptr;
     }
     if(ec) return nullptr;
-    return execstack->empty() ? incVarRef(getNil()) : execstack->pop(false);
+    return execstack->size() <= stackBase ? incVarRef(getNil()) : execstack->pop(false);
+}
+
+void VirtualMachine::releaseEvalModule(VarModule *mod)
+{
+    if(mod->getRef() <= 1) removeModule(mod);
+    decVarRef(mod);
 }
 
 } // namespace fer
\ No newline at end of file
@@ -13,6 +13,7 @@ int VirtualMachine::execute(Var *&ret, size_t *currentlyAt, size_t begin, size_t
 
     Vector<FeralFnBody> bodies;
     Vector<Var *> args;
+    Vector<Var *> unpackedArgs; // args (from unpacking) which hold a reference
     VarMap *assnArgs   = incVarRef(makeVar<VarMap>({}, true, false));
     size_t currBlkSize = 0;
 
@@ -43,7 +44,8 @@ int VirtualMachine::execute(Var *&ret, size_t *currentlyAt, size_t begin, size_t
                 }
                 execstack->push(res);
             } else {
-                Var *res = vars->getAttr(ins.getDataStr());
+                bool local = false;
+                Var *res   = vars->getAttr(ins.getDataStr(), local);
                 if(!res) {
                     res = getGlobal(ins.getDataStr());
                     if(!res) {
@@ -51,7 +53,11 @@ int VirtualMachine::execute(Var *&ret, size_t *currentlyAt, size_t begin, size_t
                         goto handleErr;
                     }
                 }
-                execstack->push(res);
+                // Owned by a frame of this VM, no need to count the stack's reference. The module
+                // frames and the globals are shared with the other VMs (threads), which can release
+                // their vars at any time.
+                if(local) execstack->pushBorrowed(res);
+                else execstack->push(res);
             }
             break;
         }
@@ -67,18 +73,22 @@ int VirtualMachine::execute(Var *&ret, size_t *currentlyAt, size_t begin, size_t
         }
         case Opcode::CREATE: {
             StringRef name = ins.getDataStr();
-            Var *val       = execstack->pop(false);
+            bool counted   = false;
+            Var *val       = execstack->popSlot(counted);
             if(!val) {
                 fail(ins.getLoc(), "expected a value in stack for creating variable: ", name,
                      ", but found none");
                 goto handleErr;
             }
             if(ins.hasComment()) { val->setDoc(*this, ins.getLoc(), ins.getComment()); }
-            // only copy if reference count > 1 (no point in copying unique values)
-            Var *cp = copyVar(ins.getLoc(), val, val->getRef() == 1);
-            if(!cp) goto handleErr;
+            // only copy if the stack holds the sole reference (no point in copying unique values)
+            Var *cp = copyVar(ins.getLoc(), val, counted && val->getRef() == 1);
+            if(!cp) {
+                if(counted) decVarRef(val);
+                goto handleErr;
+            }
             vars->setAttr(*this, name, cp, false);
-            decVarRef(val);
+            if(counted) decVarRef(val);
             clearRefVarsFrame();
             break;
         }
@@ -114,34 +124,37 @@ int VirtualMachine::execute(Var *&ret, size_t *currentlyAt, size_t begin, size_t
                      " item(s), required 2 for store operation");
                 goto handleErr;
             }
-            Var *var = execstack->pop(false);
-            Var *val = execstack->pop(false);
+            Var *var = execstack->back();
+            Var *val = execstack->at(execstack->size() - 2);
             // TODO: check if this works for assigning one struct instance of type X to
             // another struct instance of type Y
             if(var->getType() != val->getType()) {
                 fail(ins.getLoc(), "type mismatch for assignment: ", getTypeName(val),
                      " cannot be assigned to variable of type: ", getTypeName(var));
-                decVarRef(val);
-                decVarRef(var);
-                goto handleErr;
+                goto storeFail;
             }
             if(var->isConst()) {
                 fail(ins.getLoc(),
                      "cannot assign to a const marked variable of type: ", getTypeName(var));
-                decVarRef(val);
-                decVarRef(var);
-                goto handleErr;
+                goto storeFail;
             }
             if(!var->set(*this, val)) {
                 fail(ins.getLoc(), "failed to assign: ", getTypeName(val),
                      " to: ", getTypeName(var));
-                decVarRef(val);
-                decVarRef(var);
-                goto handleErr;
+                goto storeFail;
+            }
+            {
+                // leave var (in the same slot kind) in place of val
+                bool counted = false;
+                execstack->popSlot(counted);
+                execstack->pop();
+                execstack->pushSlot(var, counted);
             }
-            execstack->push(var, false);
-            decVarRef(val);
             break;
+        storeFail:
+            execstack->pop();
+            execstack->pop();
+            goto handleErr;
         }
         case Opcode::PUSH_BLOCK: {
             vars->pushBlk(*this, {}, ins.getDataInt());
@@ -225,30 +238,33 @@ int VirtualMachine::execute(Var *&ret, size_t *currentlyAt, size_t begin, size_t
         }
         case Opcode::MEM_CALL: // fallthrough
         case Opcode::CALL: {
-            // self is not decVarRef()'d manually at the end because it becomes a
-            // part of args anyway
+            // The function, self and the args stay on the exec stack until the call is done, so
+            // they remain reachable (and borrowed slots need not be counted) during the call.
             Var *self   = nullptr; // only for memcall
             Var *fnbase = nullptr;
             String fnname;
             // setup call args
             args.clear();
+            unpackedArgs.clear();
             assnArgs->clear(*this);
             bool memcall      = ins.getOpcode() == Opcode::MEM_CALL;
             StringRef arginfo = ins.getDataStr();
             Var *res          = nullptr;
+            size_t argsBegin  = execstack->size(); // lowest stack slot used by this call
             for(size_t i = 0; i < arginfo.size(); ++i) {
                 if(arginfo[i] == '2') { // unpack
-                    Var *a = execstack->pop(false);
+                    Var *a = execstack->at(--argsBegin);
                     if(!a->is<VarVec>() && !a->is<VarMap>()) {
                         fail(ins.getLoc(),
                              "expected a vector or kwarg to unpack, found: ", getTypeName(a));
-                        decVarRef(a);
                         goto callFail;
                     }
                     if(a->is<VarVec>()) {
+                        // the vector may be modified during the call
                         for(auto &va : as<VarVec>(a)->getVal()) {
                             incVarRef(va);
                             args.push_back(va);
+                            unpackedArgs.push_back(va);
                         }
                     } else if(a->is<VarMap>()) {
                         VarMap *atmp = as<VarMap>(a);
@@ -256,26 +272,26 @@ int VirtualMachine::execute(Var *&ret, size_t *currentlyAt, size_t begin, size_t
                             assnArgs->setAttr(*this, it.key(), it.val(), true);
                         }
                     }
-                    decVarRef(a);
                 } else if(arginfo[i] == '1') {
-                    VarStr *name = as<VarStr>(execstack->pop(false));
-                    Var *val     = execstack->pop(false);
-                    assnArgs->setAttr(*this, name->getVal(), val, false);
-                    decVarRef(name);
+                    VarStr *name = as<VarStr>(execstack->at(--argsBegin));
+                    Var *val     = execstack->at(--argsBegin);
+                    assnArgs->setAttr(*this, name->getVal(), val, true);
                 } else if(arginfo[i] == '0') {
-                    args.push_back(execstack->pop(false));
+                    args.push_back(execstack->at(--argsBegin));
                 }
             }
 
             // fetch the function
             if(memcall) {
-                fnname = as<VarStr>(execstack->back())->getVal();
-                execstack->pop();
-                self = execstack->pop(false);
+                fnname = as<VarStr>(execstack->at(--argsBegin))->getVal();
+                self   = execstack->at(--argsBegin);
+                if(self->is<VarModule>() && !as<VarModule>(self)->load(*this, ins.getLoc())) {
+                    goto callFail;
+                }
                 if(self->isAttrBased()) fnbase = self->getAttr(fnname);
                 if(!fnbase) fnbase = getTypeFn(self, fnname);
             } else {
-                fnbase = execstack->pop(false);
+                fnbase = execstack->at(--argsBegin);
             }
             if(!fnbase) {
                 if(memcall) {
@@ -284,18 +300,19 @@ int VirtualMachine::execute(Var *&ret, size_t *currentlyAt, size_t begin, size_t
                 } else {
                     fail(ins.getLoc(), "this function does not exist");
                 }
-                decVarRef(self);
                 goto callFail;
             }
             if(!fnbase->isCallable()) {
                 fail(ins.getLoc(), "'", getTypeName(fnbase), "' is not a callable type");
-                decVarRef(self);
                 goto callFail;
             }
             args.insert(args.begin(), self);
 
             // call the function
-            if(!(res = fnbase->call(*this, ins.getLoc(), args, assnArgs))) {
+            if(gs->allocProfiler) callLocs.push_back(ins.getLoc());
+            res = fnbase->call(*this, ins.getLoc(), args, assnArgs);
+            if(gs->allocProfiler && !callLocs.empty()) callLocs.pop_back();
+            if(!res) {
                 // don't show the following failure when exec stack count is
                 // exceeded or there'll be a GIANT stack trace
                 if(!recurseExceeded) {
@@ -303,13 +320,13 @@ int VirtualMachine::execute(Var *&ret, size_t *currentlyAt, size_t begin, size_t
                 }
                 goto callFail;
             }
-            execstack->push(res, false);
-            if(!ready) goto callFail;
 
             // cleanup
             assnArgs->clear(*this);
-            for(auto &a : args) decVarRef(a);
-            if(!memcall) decVarRef(fnbase);
+            for(auto &a : unpackedArgs) decVarRef(a);
+            execstack->popTill(argsBegin);
+            execstack->push(res, false);
+            if(!ready) goto handleErr;
             if(isExitCalled()) {
                 ret = execstack->pop(false);
                 goto done;
@@ -317,15 +334,64 @@ int VirtualMachine::execute(Var *&ret, size_t *currentlyAt, size_t begin, size_t
             break;
         callFail:
             assnArgs->clear(*this);
-            for(auto &a : args) decVarRef(a);
-            if(!memcall) decVarRef(fnbase);
+            for(auto &a : unpackedArgs) decVarRef(a);
+            execstack->popTill(argsBegin);
             goto handleErr;
         }
+        case Opcode::ADD_CHAIN: {
+            size_t count     = ins.getDataInt();
+            size_t argsBegin = execstack->size() - count;
+            Var *fnbase      = nullptr;
+            Var *res         = nullptr;
+            // the operands stay on the exec stack till the chain is done (see CALL)
+            args.resize(count);
+            for(size_t j = 0; j < count; ++j) args[j] = execstack->at(argsBegin + j);
+            assnArgs->clear(*this);
+            if(args[0]->is<VarModule>() && !as<VarModule>(args[0])->load(*this, ins.getLoc())) {
+                execstack->popTill(argsBegin);
+                goto handleErr;
+            }
+            if(gs->allocProfiler) callLocs.push_back(ins.getLoc());
+            if(args[0]->isAttrBased()) fnbase = args[0]->getAttr("+");
+            if(!fnbase) fnbase = getTypeFn(args[0], "+");
+            if(fnbase && fnbase->is<VarFn>() && as<VarFn>(fnbase)->isNative() &&
+               as<VarFn>(fnbase)->isVariadic())
+            {
+                // the native function can add all the values in one go
+                res = callVar(ins.getLoc(), "+", fnbase, args, assnArgs);
+            } else {
+                res = incVarRef(args[0]);
+                for(size_t j = 1; res && j < count; ++j) {
+                    Array<Var *, 2> pair{res, args[j]};
+                    Var *next = callVar(ins.getLoc(), "+", pair, assnArgs);
+                    decVarRef(res);
+                    res = next;
+                }
+            }
+            if(gs->allocProfiler && !callLocs.empty()) callLocs.pop_back();
+            assnArgs->clear(*this);
+            execstack->popTill(argsBegin);
+            if(!res) goto handleErr;
+            execstack->push(res, false);
+            if(isExitCalled()) {
+                ret = execstack->pop(false);
+                goto done;
+            }
+            break;
+        }
         case Opcode::ATTR: {
             StringRef attr = ins.getDataStr();
-            Var *inbase    = execstack->pop(false);
+            Var *inbase    = execstack->back();
             Var *val       = nullptr;
-            if(inbase->isAttrBased()) val = inbase->getAttr(attr);
+            if(inbase->is<VarModule>() && !as<VarModule>(inbase)->load(*this, ins.getLoc())) {
+                execstack->pop();
+                goto handleErr;
+            }
+            if(inbase->is<VarStruct>()) {
+                val = as<VarStruct>(inbase)->getAttrCached(attr, ins.getAttrCache());
+            } else if(inbase->isAttrBased()) {
+                val = inbase->getAttr(attr);
+            }
             if(!val) {
                 val = getTypeFn(inbase, attr);
                 if(val) {
@@ -337,11 +403,13 @@ int VirtualMachine::execute(Var *&ret, size_t *currentlyAt, size_t begin, size_t
             if(!val) {
                 fail(ins.getLoc(), "type ", getTypeName(inbase),
                      " does not contain attribute: ", attr);
-                decVarRef(inbase);
+                execstack->pop();
                 goto handleErr;
             }
-            execstack->push(val);
-            decVarRef(inbase);
+            // val may be owned by inbase alone
+            incVarRef(val);
+            execstack->pop();
+            execstack->push(val, false);
             break;
         }
         case Opcode::RETURN: {
@@ -5,6 +5,8 @@
 namespace fer
 {
 
+bool loadLazyModule(VirtualMachine &vm, ModuleLoc loc, VarModule *mod);
+
 static size_t genStructEnumID()
 {
     static size_t id = -1;
@@ -156,7 +158,7 @@ void Var::dump(String &outStr, VirtualMachine *vm)
         outStr += std::to_string(as<VarFlt>(this)->getVal());
     } else if(is<VarStr>()) {
         outStr += "Str:";
-        outStr += as<VarStr>(this)->getVal();
+        outStr += as<VarStr>(this)->getView();
     } else if(is<VarPath>()) {
         outStr += "Path:";
         outStr += as<VarPath>(this)->toStr();
@@ -263,20 +265,88 @@ bool VarFlt::onSet(VirtualMachine &vm, Var *from)
 ////////////////////////////////////////// VarStr ////////////////////////////////////////////////
 //////////////////////////////////////////////////////////////////////////////////////////////////
 
-VarStr::VarStr(ModuleLoc loc, char val) : Var(loc), val(1, val) {}
-VarStr::VarStr(ModuleLoc loc, String &&val) : Var(loc), val(std::move(val)) {}
-VarStr::VarStr(ModuleLoc loc, StringRef val) : Var(loc), val(val) {}
-VarStr::VarStr(ModuleLoc loc, const char *val) : Var(loc), val(val) {}
-VarStr::VarStr(ModuleLoc loc, InitList<StringRef> _val) : Var(loc)
+VarStr::VarStr(ModuleLoc loc, char val) : Var(loc), val(1, val), offset(0), count(0) {}
+VarStr::VarStr(ModuleLoc loc, String &&val)
+    : Var(loc), val(std::move(val)), offset(0), count(0)
+{
+    initShared();
+}
+VarStr::VarStr(ModuleLoc loc, StringRef val) : Var(loc), val(val), offset(0), count(0)
+{
+    initShared();
+}
+VarStr::VarStr(ModuleLoc loc, const char *val) : Var(loc), val(val), offset(0), count(0)
+{
+    initShared();
+}
+VarStr::VarStr(ModuleLoc loc, InitList<StringRef> _val) : Var(loc), offset(0), count(0)
 {
     for(auto &e : _val) val += e;
+    initShared();
+}
+VarStr::VarStr(ModuleLoc loc, const char *val, size_t count)
+    : Var(loc), val(val, count), offset(0), count(0)
+{
+    initShared();
+}
+VarStr::VarStr(ModuleLoc loc, VarStr *src, size_t pos, size_t len)
+    : Var(loc), offset(0), count(0)
+{
+    share(src, pos, len);
 }
-VarStr::VarStr(ModuleLoc loc, const char *val, size_t count) : Var(loc), val(val, count) {}
 bool VarStr::onSet(VirtualMachine &vm, Var *from)
 {
-    val = as<VarStr>(from)->getVal();
+    share(as<VarStr>(from), 0, String::npos);
     return true;
 }
+void VarStr::initShared()
+{
+    if(val.size() < STR_SHARE_MIN_LEN) return;
+    shared = std::make_shared<String>(std::move(val));
+    val.clear();
+    offset = 0;
+    count  = shared->size();
+}
+void VarStr::share(VarStr *src, size_t pos, size_t len)
+{
+    StringRef data = src->getView();
+    if(pos > data.size()) pos = data.size();
+    len = std::min(len, data.size() - pos);
+    // src is not modified here - if it does not have a shared buffer (it was modified after its
+    // creation), the contents are copied instead.
+    if(len < STR_SHARE_MIN_LEN || src == this || !src->shared) {
+        // src may be this itself, in which case val is assigned from its own substring
+        String tmp(data.substr(pos, len));
+        shared.reset();
+        val = std::move(tmp);
+        initShared();
+        return;
+    }
+    val.clear();
+    val.shrink_to_fit();
+    shared = src->shared;
+    offset = src->offset + pos;
+    count  = len;
+}
+void VarStr::unshare()
+{
+    if(shared.use_count() == 1 && offset == 0 && count == shared->size()) {
+        val = std::move(*shared);
+    } else {
+        val.assign(shared->data() + offset, count);
+    }
+    shared.reset();
+}
+void VarStr::shrink(size_t front, size_t back)
+{
+    if(!shared) {
+        val.erase(val.size() - back);
+        val.erase(0, front);
+        return;
+    }
+    offset += front;
+    count -= front + back;
+}
 
 //////////////////////////////////////////////////////////////////////////////////////////////////
 ////////////////////////////////////////// VarVec ////////////////////////////////////////////////
@@ -357,138 +427,85 @@ bool VarVecIterator::next(Var *&val)
 ////////////////////////////////////////// VarMap ////////////////////////////////////////////////
 //////////////////////////////////////////////////////////////////////////////////////////////////
 
-VarMap::Iterator::Iterator(void *orderiter, StringMap<Var *>::iterator dataiter, bool forward)
-    : orderiter(orderiter), dataiter(dataiter), forward(forward)
-{}
+VarMap::Iterator::Iterator(OrderedStringMap<Var *> *map, size_t pos) : map(map), pos(pos) {}
 
 VarMap::VarMap(ModuleLoc loc, bool ordered, bool asrefs)
-    : Var(loc, VarInfo::ATTR_BASED), keyOrder(nullptr), ordered(ordered), asrefs(asrefs)
+    : Var(loc, VarInfo::ATTR_BASED), ordered(ordered), asrefs(asrefs)
 {}
-void VarMap::onCreate(VirtualMachine &vm)
-{
-    MemoryManager &mem = vm.getMemoryManager();
-    if(isOrdered()) keyOrder = mem.allocInit<ManagedRawList>(mem, "VarMap");
-}
-void VarMap::onDestroy(VirtualMachine &vm)
+void VarMap::onDestroy(VirtualMachine &vm) { clear(vm); }
+bool VarMap::onSet(VirtualMachine &vm, Var *from) { return setVal(vm, as<VarMap>(from)->getVal()); }
+bool VarMap::setVal(VirtualMachine &vm, OrderedStringMap<Var *> &newval)
 {
     clear(vm);
-    MemoryManager &mem = vm.getMemoryManager();
-    if(isOrdered()) mem.freeDeinit(keyOrder);
-}
-bool VarMap::onSet(VirtualMachine &vm, Var *from)
-{
-    return setVal(vm, as<VarMap>(from)->getVal(), as<VarMap>(from)->getOrder());
-}
-bool VarMap::setVal(VirtualMachine &vm, const StringMap<Var *> &newval, ManagedRawList *order)
-{
-    clear(vm);
-    if(order) {
-        char *it = nullptr;
-        while((it = (char *)order->next(it))) {
-            Var *tmp = newval.at(it);
-            tmp      = vm.copyVar(tmp->getLoc(), tmp, asrefs);
-            setAttr(vm, it, tmp, false);
-        }
-    } else {
-        for(auto &v : newval) {
-            Var *tmp = vm.copyVar(v.second->getLoc(), v.second, asrefs);
-            val.insert({v.first, tmp});
-        }
+    val.reserve(newval.size());
+    for(auto &e : newval) {
+        Var *tmp = vm.copyVar(e.second->getLoc(), e.second, asrefs);
+        val.insert(e.first, tmp);
     }
     return true;
 }
 void VarMap::clear(VirtualMachine &vm)
 {
-    if(isOrdered()) {
-        char *it = nullptr;
-        while((it = (char *)keyOrder->prev(it))) { vm.decVarRef(val[it]); }
-        keyOrder->clear();
-    } else {
-        for(auto &v : val) vm.decVarRef(v.second);
-    }
+    for(auto &e : val) vm.decVarRef(e.second);
     val.clear();
 }
 void VarMap::setAttr(VirtualMachine &vm, StringRef name, Var *val, bool iref)
 {
     if(iref) vm.incVarRef(val);
-    auto loc = this->val.find(name);
-    if(loc != this->val.end()) {
-        vm.decVarRef(loc->second);
-        loc->second = val;
+    auto *e = this->val.find(name);
+    if(e) {
+        vm.decVarRef(e->second);
+        e->second = val;
         return;
     }
-    if(isOrdered()) addOrder(name);
-    this->val.insert({String(name), val});
-    return;
+    this->val.insert(name, val);
 }
 void VarMap::remAttr(VirtualMachine &vm, StringRef name, bool &found, bool dref)
 {
-    auto loc = val.find(name);
-    if(loc == val.end()) return;
-    found = true;
-    if(isOrdered()) remOrder(name);
-    if(dref) vm.decVarRef(loc->second);
-    val.erase(loc);
+    auto *e = val.find(name);
+    if(!e) return;
+    found    = true;
+    Var *tmp = e->second;
+    val.erase(e);
+    if(dref) vm.decVarRef(tmp);
 }
 bool VarMap::replaceAttr(VirtualMachine &vm, StringRef name, Var *val, bool iref)
 {
-    auto loc = this->val.find(name);
-    if(loc == this->val.end()) return false;
-    vm.decVarRef(loc->second);
-    loc->second = iref ? vm.incVarRef(val) : val;
+    auto *e = this->val.find(name);
+    if(!e) return false;
+    vm.decVarRef(e->second);
+    e->second = iref ? vm.incVarRef(val) : val;
     return true;
 }
-bool VarMap::existsAttr(StringRef name) { return this->val.find(name) != this->val.end(); }
+bool VarMap::existsAttr(StringRef name) { return val.contains(name); }
 Var *VarMap::getAttr(StringRef name)
 {
-    auto loc = this->val.find(name);
-    if(loc == this->val.end()) return nullptr;
-    return loc->second;
+    auto *e = val.find(name);
+    return e ? e->second : nullptr;
 }
 void VarMap::getAttrList(VirtualMachine &vm, VarVec *dest)
 {
-    if(isOrdered()) {
-        char *it = nullptr;
-        while((it = (char *)keyOrder->next(it))) {
-            dest->push(vm, vm.makeVar<VarStr>(dest->getLoc(), it), true);
-        }
-        return;
-    }
     for(auto &e : val) dest->push(vm, vm.makeVar<VarStr>(dest->getLoc(), e.first), true);
 }
 
-VarMap::Iterator VarMap::begin(bool forward)
+VarMap::Iterator VarMap::begin()
 {
-    if(isOrdered()) {
-        char *key = (char *)keyOrder->next();
-        if(!key) return end();
-        return Iterator(key, val.find(key), forward);
-    }
-    return Iterator(nullptr, val.begin(), true);
+    Iterator it(&val, 0);
+    revalidate(it);
+    return it;
 }
 
 void VarMap::next(VarMap::Iterator &it)
 {
-    if(isOrdered()) {
-        char *key = nullptr;
-        if(it.isForward()) key = (char *)keyOrder->next(it.orderiter);
-        else key = (char *)keyOrder->prev(it.orderiter);
-        it.orderiter = key;
-        it.dataiter  = key ? val.find(key) : val.end();
-        return;
-    }
-    ++it.dataiter;
+    ++it.pos;
+    revalidate(it);
 }
 
-void VarMap::addOrder(StringRef name) { keyOrder->allocInit<char>(name.data(), name.size() + 1); }
-void VarMap::remOrder(StringRef name)
+void VarMap::revalidate(VarMap::Iterator &it)
 {
-    char *it = nullptr;
-    while((it = (char *)keyOrder->next(it))) {
-        if(name != it) continue;
-        keyOrder->free(it);
-        break;
-    }
+    if(it.pos == SIZE_MAX) return;
+    it.pos = val.skipErased(it.pos);
+    if(it.pos >= val.getEndPos()) it.pos = SIZE_MAX;
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////////
@@ -497,11 +514,21 @@ void VarMap::remOrder(StringRef name)
 
 VarMapIterator::VarMapIterator(ModuleLoc loc, VarMap *map) : Var(loc), map(map), curr(map->begin())
 {}
-void VarMapIterator::onCreate(VirtualMachine &vm) { vm.incVarRef(map); }
-void VarMapIterator::onDestroy(VirtualMachine &vm) { vm.decVarRef(map); }
+void VarMapIterator::onCreate(VirtualMachine &vm)
+{
+    vm.incVarRef(map);
+    map->getVal().pinPositions();
+}
+void VarMapIterator::onDestroy(VirtualMachine &vm)
+{
+    map->getVal().unpinPositions();
+    vm.decVarRef(map);
+}
 
 bool VarMapIterator::next(VirtualMachine &vm, ModuleLoc loc, Var *&val)
 {
+    // the map may have been modified since the last call
+    map->revalidate(curr);
     if(curr == map->end()) return false;
     StringMap<Var *> attrs;
     val = vm.makeVar<VarStruct>(loc, nullptr, typeID<VarMapIterator>());
@@ -512,6 +539,177 @@ bool VarMapIterator::next(VirtualMachine &vm, ModuleLoc loc, Var *&val)
     return true;
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////// VarHashMap /////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Spreads the bits of integer (and float) hashes, since the table uses the low bits of the hash.
+static inline size_t mixHash(uint64_t x)
+{
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    return x;
+}
+
+static bool hashKey(VirtualMachine &vm, ModuleLoc loc, Var *key, size_t &hash)
+{
+    if(key->is<VarInt>()) {
+        hash = mixHash(as<VarInt>(key)->getVal());
+    } else if(key->is<VarStr>()) {
+        hash = std::hash<StringRef>{}(as<VarStr>(key)->getView());
+    } else if(key->is<VarFlt>()) {
+        double d = as<VarFlt>(key)->getVal();
+        if(d == 0.0) d = 0.0; // same hash for -0.0
+        hash = mixHash(std::bit_cast<uint64_t>(d));
+    } else if(key->is<VarBool>()) {
+        hash = as<VarBool>(key)->getVal();
+    } else if(key->is<VarNil>()) {
+        hash = 0;
+    } else if(key->is<VarStruct>()) {
+        Var *res = nullptr;
+        Array<Var *, 1> args{key};
+        if(!vm.callVarAndExpect<VarInt>(loc, "hash", res, args, nullptr)) {
+            vm.fail(loc, "failed to get the hash of the struct key of type: ",
+                    vm.getTypeName(key));
+            return false;
+        }
+        hash = mixHash(as<VarInt>(res)->getVal());
+        vm.decVarRef(res);
+    } else {
+        vm.fail(loc, "type: ", vm.getTypeName(key), " cannot be used as a HashMap key");
+        return false;
+    }
+    return true;
+}
+
+// Sets `failed` if the == member function of a struct fails.
+static bool keysEqual(VirtualMachine &vm, ModuleLoc loc, Var *a, Var *b, bool &failed)
+{
+    if(a == b) return true;
+    if(a->getSubType() != b->getSubType()) return false;
+    if(a->is<VarInt>()) return as<VarInt>(a)->getVal() == as<VarInt>(b)->getVal();
+    if(a->is<VarStr>()) return as<VarStr>(a)->getView() == as<VarStr>(b)->getView();
+    if(a->is<VarFlt>()) return as<VarFlt>(a)->getVal() == as<VarFlt>(b)->getVal();
+    if(a->is<VarBool>()) return as<VarBool>(a)->getVal() == as<VarBool>(b)->getVal();
+    if(a->is<VarNil>()) return true;
+    Var *res = nullptr;
+    Array<Var *, 2> args{a, b};
+    if(!vm.callVarAndExpect<VarBool>(loc, "==", res, args, nullptr)) {
+        failed = true;
+        return false;
+    }
+    bool eq = as<VarBool>(res)->getVal();
+    vm.decVarRef(res);
+    return eq;
+}
+
+VarHashMap::VarHashMap(ModuleLoc loc, bool asrefs) : Var(loc), asrefs(asrefs) {}
+void VarHashMap::onDestroy(VirtualMachine &vm) { clear(vm); }
+bool VarHashMap::onSet(VirtualMachine &vm, Var *from)
+{
+    VarHashMap *src = as<VarHashMap>(from);
+    if(src == this) return true;
+    clear(vm);
+    val.reserve(src->size());
+    // the keys are already unique, and have their hashes
+    for(auto &e : src->getVal()) {
+        Var *k = vm.copyVar(e.first->getLoc(), e.first, false);
+        if(!k) return false;
+        Var *v = vm.copyVar(e.second->getLoc(), e.second, asrefs);
+        if(!v) {
+            vm.decVarRef(k);
+            return false;
+        }
+        val.insert(std::move(k), v, e.hash);
+    }
+    return true;
+}
+
+bool VarHashMap::find(VirtualMachine &vm, ModuleLoc loc, Var *key, Entry *&res)
+{
+    size_t hash = 0;
+    if(!hashKey(vm, loc, key, hash)) return false;
+    bool failed = false;
+    res = val.find(hash, [&](Var *k) { return !failed && keysEqual(vm, loc, k, key, failed); });
+    return !failed;
+}
+bool VarHashMap::insert(VirtualMachine &vm, ModuleLoc loc, Var *key, Var *val)
+{
+    size_t hash = 0;
+    if(!hashKey(vm, loc, key, hash)) return false;
+    bool failed = false;
+    Entry *e =
+        this->val.find(hash, [&](Var *k) { return !failed && keysEqual(vm, loc, k, key, failed); });
+    if(failed) return false;
+    if(e) {
+        vm.decVarRef(e->second);
+        e->second = val;
+        return true;
+    }
+    Var *k = vm.copyVar(loc, key, false);
+    if(!k) return false;
+    this->val.insert(std::move(k), val, hash);
+    return true;
+}
+bool VarHashMap::erase(VirtualMachine &vm, ModuleLoc loc, Var *key)
+{
+    Entry *e = nullptr;
+    if(!find(vm, loc, key, e)) return false;
+    if(!e) return true;
+    Var *k = e->first, *v = e->second;
+    val.erase(e);
+    vm.decVarRef(k);
+    vm.decVarRef(v);
+    return true;
+}
+void VarHashMap::clear(VirtualMachine &vm)
+{
+    for(auto &e : val) {
+        vm.decVarRef(e.first);
+        vm.decVarRef(e.second);
+    }
+    val.clear();
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////// VarHashMapIterator /////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+VarHashMapIterator::VarHashMapIterator(ModuleLoc loc, VarHashMap *map)
+    : Var(loc), map(map), pos(0)
+{}
+void VarHashMapIterator::onCreate(VirtualMachine &vm)
+{
+    vm.incVarRef(map);
+    map->getVal().pinPositions();
+}
+void VarHashMapIterator::onDestroy(VirtualMachine &vm)
+{
+    map->getVal().unpinPositions();
+    vm.decVarRef(map);
+}
+
+bool VarHashMapIterator::next(VirtualMachine &vm, ModuleLoc loc, Var *&val)
+{
+    // positions stay valid (and erased entries are skipped) if the map is modified in between
+    pos = map->getVal().skipErased(pos);
+    if(pos >= map->getVal().getEndPos()) return false;
+    auto &e = map->getVal().getAt(pos++);
+    // the keys are copied (like on insert) so that modifying them cannot change their hashes in
+    // the map
+    Var *key = vm.copyVar(loc, e.first, false);
+    if(!key) {
+        val = nullptr;
+        return true;
+    }
+    val = vm.makeVar<VarStruct>(loc, nullptr, typeID<VarHashMapIterator>());
+    as<VarStruct>(val)->reserveAttrs(2);
+    as<VarStruct>(val)->setAttr(vm, "0", key, false);
+    as<VarStruct>(val)->setAttr(vm, "1", vm.incVarRef(e.second), false);
+    return true;
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////////
 ////////////////////////////////////////// VarFn /////////////////////////////////////////////////
 //////////////////////////////////////////////////////////////////////////////////////////////////
@@ -660,43 +858,72 @@ Var *VarAsync::onCall(VirtualMachine &vm, ModuleLoc loc, Span<Var *> args, VarMa
 VarModule::VarModule(ModuleLoc loc, StringRef path, Bytecode &&bc, ModuleId moduleId,
                      bool isVirtual)
     : Var(loc, VarInfo::ATTR_BASED), path(path), bc(std::move(bc)), moduleId(moduleId),
-      moduleFrame(nullptr), virtualMod(isVirtual)
+      moduleFrame(nullptr), virtualMod(isVirtual), lazy(false)
+{}
+VarModule::VarModule(ModuleLoc loc, StringRef path)
+    : Var(loc, VarInfo::ATTR_BASED), path(path), moduleId(0), moduleFrame(nullptr),
+      virtualMod(false), lazy(true)
 {}
 void VarModule::onCreate(VirtualMachine &vm)
 {
-    if(!virtualMod) moduleFrame = vm.incVarRef(vm.makeVar<VarFrame>(getLoc()));
+    if(!virtualMod && !isLazy()) moduleFrame = vm.incVarRef(vm.makeVar<VarFrame>(getLoc()));
 }
 void VarModule::onDestroy(VirtualMachine &vm)
 {
     if(moduleFrame) vm.decVarRef(moduleFrame);
 }
+bool VarModule::importLazy(VirtualMachine &vm, ModuleLoc loc)
+{
+    return loadLazyModule(vm, loc, this);
+}
+void VarModule::setImported(VirtualMachine &vm, VarModule *mod)
+{
+    moduleFrame = vm.incVarRef(mod->getVarFrame());
+    lazy.store(false, std::memory_order_release);
+}
 void VarModule::setAttr(VirtualMachine &vm, StringRef name, Var *val, bool iref)
 {
+    if(!load(vm, getLoc())) return;
     assert(moduleFrame);
     moduleFrame->setAttr(vm, name, val, iref);
 }
 bool VarModule::replaceAttr(VirtualMachine &vm, StringRef name, Var *val, bool iref)
 {
+    if(!load(vm, getLoc())) return false;
     assert(moduleFrame);
     return moduleFrame->replaceAttr(vm, name, val, iref);
 }
+// The functions without a VM cannot import a lazy module, so their callers must load() it first.
+// Reaching them with a lazy module is a bug in the caller, which is reported instead of silently
+// treating the module as empty.
+static bool lazyWithoutVM(VarModule *mod)
+{
+    if(!mod->isLazy()) return false;
+    err.fail(mod->getLoc(), "internal error: lazy module '", mod->getPath(),
+             "' used without being imported");
+    return true;
+}
 bool VarModule::existsAttr(StringRef name)
 {
+    if(lazyWithoutVM(this)) return false;
     assert(moduleFrame);
     return moduleFrame->existsAttr(name);
 }
 Var *VarModule::getAttr(StringRef name)
 {
+    if(lazyWithoutVM(this)) return nullptr;
     assert(moduleFrame);
     return moduleFrame->getAttr(name);
 }
 void VarModule::getAttrList(VirtualMachine &vm, VarVec *dest)
 {
+    if(!load(vm, getLoc())) return;
     assert(moduleFrame);
     return moduleFrame->getAttrList(vm, dest);
 }
 size_t VarModule::getAttrCount()
 {
+    if(lazyWithoutVM(this)) return 0;
     assert(moduleFrame);
     return moduleFrame->getAttrCount();
 }
@@ -713,20 +940,38 @@ void VarFrame::onCreate(VirtualMachine &vm)
 }
 void VarFrame::onDestroy(VirtualMachine &vm) { vm.decVarRef(frame); }
 
+// The vars of a frame can be on the exec stack as borrowed references, so the ones it lets go of
+// are released using decFrameVarRef().
 void VarFrame::setAttr(VirtualMachine &vm, StringRef name, Var *val, bool iref)
 {
     LockGuard<RecursiveMutex> _(mtx);
-    return frame->setAttr(vm, name, val, iref);
+    if(iref) vm.incVarRef(val);
+    auto *e = frame->getVal().find(name);
+    if(e) {
+        vm.decFrameVarRef(e->second);
+        e->second = val;
+        return;
+    }
+    frame->getVal().insert(name, val);
 }
 void VarFrame::remAttr(VirtualMachine &vm, StringRef name, bool &found, bool dref)
 {
     LockGuard<RecursiveMutex> _(mtx);
-    return frame->remAttr(vm, name, found, dref);
+    auto *e = frame->getVal().find(name);
+    if(!e) return;
+    found    = true;
+    Var *tmp = e->second;
+    frame->getVal().erase(e);
+    if(dref) vm.decFrameVarRef(tmp);
 }
 bool VarFrame::replaceAttr(VirtualMachine &vm, StringRef name, Var *val, bool iref)
 {
     LockGuard<RecursiveMutex> _(mtx);
-    return frame->replaceAttr(vm, name, val, iref);
+    auto *e = frame->getVal().find(name);
+    if(!e) return false;
+    vm.decFrameVarRef(e->second);
+    e->second = iref ? vm.incVarRef(val) : val;
+    return true;
 }
 bool VarFrame::existsAttr(StringRef name)
 {
@@ -789,29 +1034,28 @@ Var *VarStructDef::onCall(VirtualMachine &vm, ModuleLoc loc, Span<Var *> args, V
     }
 
     VarStruct *res = vm.incVarRef(vm.createVar<VarStruct>(loc, this, id));
-    res->reserveAttrs(attrs->size());
-
-    auto it = attrs->begin();
-    for(auto argit = args.begin() + 1; argit != args.end(); ++argit) {
-        auto &arg = *argit;
-        if(it == attrs->end()) {
-            vm.fail(arg->getLoc(), "provided more arguments than existing in structure definition");
-            goto fail;
-        }
-        res->setAttr(vm, it.key(), vm.copyVar(loc, arg, false), false);
-        attrs->next(it);
-    }
 
+    if(args.size() - 1 > attrs->size()) {
+        vm.fail(args[attrs->size() + 1]->getLoc(),
+                "provided more arguments than existing in structure definition");
+        goto fail;
+    }
+    for(size_t i = 1; i < args.size(); ++i) {
+        Var *cp = vm.copyVar(loc, args[i], false);
+        if(!cp) goto fail;
+        res->setField(vm, i - 1, cp);
+    }
     for(auto aa = assnArgs->begin(); aa != assnArgs->end(); assnArgs->next(aa)) {
-        res->setAttr(vm, aa.key(), vm.copyVar(loc, aa.val(), false), false);
+        Var *cp = vm.copyVar(loc, aa.val(), false);
+        if(!cp) goto fail;
+        res->setField(vm, getFieldIndex(aa.key()), cp);
     }
-    while(it != attrs->end()) {
-        if(!res->existsAttr(it.key())) {
-            Var *cp = vm.copyVar(loc, it.val(), false);
-            if(!cp) return nullptr;
-            res->setAttr(vm, it.key(), cp, false);
-        }
-        attrs->next(it);
+    // the remaining fields get (copies of) the default values
+    for(size_t i = 0; i < attrs->size(); ++i) {
+        if(res->hasField(i)) continue;
+        Var *cp = vm.copyVar(loc, attrs->getVal().getAt(i).second, false);
+        if(!cp) goto fail;
+        res->setField(vm, i, cp);
     }
 
     return vm.initVar(res);
@@ -820,32 +1064,61 @@ fail:
     return nullptr;
 }
 
+size_t VarStructDef::getFieldIndex(StringRef name)
+{
+    auto *e = attrs->getVal().find(name);
+    return e ? attrs->getVal().getPos(e) : -1;
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////////
 /////////////////////////////////////////// VarStruct ////////////////////////////////////////////
 //////////////////////////////////////////////////////////////////////////////////////////////////
 
 VarStruct::VarStruct(ModuleLoc loc, VarStructDef *base)
-    : Var(loc, VarInfo::CONSTRUCTIBLE | VarInfo::ATTR_BASED), base(base), attrs(nullptr),
+    : Var(loc, VarInfo::CONSTRUCTIBLE | VarInfo::ATTR_BASED), base(base), extra(nullptr),
       id(genStructEnumID())
 {}
 VarStruct::VarStruct(ModuleLoc loc, VarStructDef *base, size_t id)
-    : Var(loc, VarInfo::CONSTRUCTIBLE | VarInfo::ATTR_BASED), base(base), attrs(nullptr), id(id)
+    : Var(loc, VarInfo::CONSTRUCTIBLE | VarInfo::ATTR_BASED), base(base), extra(nullptr), id(id)
 {}
 void VarStruct::onCreate(VirtualMachine &vm)
 {
-    if(base) vm.incVarRef(base);
-    attrs = vm.incVarRef(vm.makeVar<VarMap>(getLoc(), false, false));
+    if(base) {
+        vm.incVarRef(base);
+        fields.resize(base->getAttrCount(), nullptr);
+    } else {
+        extra = vm.incVarRef(vm.makeVar<VarMap>(getLoc(), false, false));
+    }
 }
 void VarStruct::onDestroy(VirtualMachine &vm)
 {
-    vm.decVarRef(attrs);
+    for(auto &f : fields) vm.decVarRef(f);
+    vm.decVarRef(extra);
     if(base) vm.decVarRef(base);
 }
 
 bool VarStruct::onSet(VirtualMachine &vm, Var *from)
 {
     VarStruct *st = as<VarStruct>(from);
-    if(!vm.setVar(attrs, st->attrs)) return false;
+    if(st == this) return true;
+    Vector<Var *> newFields;
+    newFields.reserve(st->fields.size());
+    for(auto &f : st->fields) {
+        Var *cp = vm.copyVar(f->getLoc(), f, false);
+        if(!cp) {
+            for(auto &nf : newFields) vm.decVarRef(nf);
+            return false;
+        }
+        newFields.push_back(cp);
+    }
+    for(auto &f : fields) vm.decVarRef(f);
+    fields = std::move(newFields);
+    if(st->extra) {
+        if(!vm.setVar(getExtra(vm), st->extra)) return false;
+    } else if(extra) {
+        vm.decVarRef(extra);
+        extra = nullptr;
+    }
     if(st->base) vm.incVarRef(st->base);
     if(base) vm.decVarRef(base);
     base = st->base;
@@ -853,6 +1126,60 @@ bool VarStruct::onSet(VirtualMachine &vm, Var *from)
     return true;
 }
 
+VarMap *VarStruct::getExtra(VirtualMachine &vm)
+{
+    if(!extra) extra = vm.incVarRef(vm.makeVar<VarMap>(getLoc(), false, false));
+    return extra;
+}
+
+void VarStruct::setAttr(VirtualMachine &vm, StringRef name, Var *val, bool iref)
+{
+    size_t idx = getFieldIndex(name);
+    if(idx == -1) return getExtra(vm)->setAttr(vm, name, val, iref);
+    setField(vm, idx, iref ? vm.incVarRef(val) : val);
+}
+bool VarStruct::replaceAttr(VirtualMachine &vm, StringRef name, Var *val, bool iref)
+{
+    size_t idx = getFieldIndex(name);
+    if(idx == -1) return extra && extra->replaceAttr(vm, name, val, iref);
+    setField(vm, idx, iref ? vm.incVarRef(val) : val);
+    return true;
+}
+bool VarStruct::existsAttr(StringRef name)
+{
+    return getFieldIndex(name) != -1 || (extra && extra->existsAttr(name));
+}
+Var *VarStruct::getAttr(StringRef name)
+{
+    size_t idx = getFieldIndex(name);
+    if(idx != -1) return fields[idx];
+    return extra ? extra->getAttr(name) : nullptr;
+}
+Var *VarStruct::getAttrCached(StringRef name, const AttrCache &cache)
+{
+    if(base) {
+        size_t idx = cache.get(base->getID());
+        if(idx == -1) {
+            idx = base->getFieldIndex(name);
+            if(idx != -1) cache.set(base->getID(), idx);
+        }
+        if(idx < fields.size()) return fields[idx];
+    }
+    return extra ? extra->getAttr(name) : nullptr;
+}
+void VarStruct::getAttrList(VirtualMachine &vm, VarVec *dest)
+{
+    for(size_t i = 0; i < fields.size(); ++i) {
+        dest->push(vm, vm.makeVar<VarStr>(dest->getLoc(), base->getFieldName(i)), true);
+    }
+    if(extra) extra->getAttrList(vm, dest);
+}
+void VarStruct::setField(VirtualMachine &vm, size_t idx, Var *val)
+{
+    vm.decVarRef(fields[idx]);
+    fields[idx] = val;
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////////
 //////////////////////////////////////// VarFailure //////////////////////////////////////////////
 //////////////////////////////////////////////////////////////////////////////////////////////////
@@ -999,6 +1326,59 @@ void VarBytebuffer::setData(const unsigned char *newbuf, size_t newlen)
     buflen = newlen;
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////// VarStrBuilder ///////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+VarStrBuilder::VarStrBuilder(ModuleLoc loc, size_t reservesz) : Var(loc) { buf.reserve(reservesz); }
+
+bool VarStrBuilder::onSet(VirtualMachine &vm, Var *from)
+{
+    buf = as<VarStrBuilder>(from)->buf;
+    return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+/////////////////////////////////////////// VarStrTemplate ///////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+VarStrTemplate::VarStrTemplate(ModuleLoc loc) : Var(loc) {}
+
+void VarStrTemplate::onDestroy(VirtualMachine &vm)
+{
+    for(auto &p : placeholders) vm.releaseEvalModule(p.mod);
+}
+
+bool VarStrTemplate::onSet(VirtualMachine &vm, Var *from)
+{
+    VarStrTemplate *src = as<VarStrTemplate>(from);
+    if(src == this) return true;
+    for(auto &p : src->placeholders) vm.incVarRef(p.mod);
+    for(auto &p : placeholders) vm.releaseEvalModule(p.mod);
+    placeholders = src->placeholders;
+    suffix       = src->suffix;
+    return true;
+}
+
+void VarStrTemplate::addPlaceholder(String &&prefix, StringRef expr, VarModule *mod)
+{
+    StringRef iden;
+    const Bytecode &bc = mod->getBytecode();
+    if(bc.size() == 1 && bc.getInstrAt(0).getOpcode() == Opcode::LOAD_DATA &&
+       bc.getInstrAt(0).isDataIden())
+    {
+        iden = bc.getInstrAt(0).getDataStr();
+    }
+    placeholders.push_back({std::move(prefix), String(expr), mod, iden});
+}
+
+size_t VarStrTemplate::getLiteralLen()
+{
+    size_t len = suffix.size();
+    for(auto &p : placeholders) len += p.prefix.size();
+    return len;
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////////
 ////////////////////////////////////////// VarStack //////////////////////////////////////////////
 //////////////////////////////////////////////////////////////////////////////////////////////////
@@ -1023,6 +1403,11 @@ bool VarStack::replaceAttr(VirtualMachine &vm, StringRef name, Var *val, bool ir
 }
 
 Var *VarStack::getAttr(StringRef name)
+{
+    bool local = false;
+    return getAttr(name, local);
+}
+Var *VarStack::getAttr(StringRef name, bool &local)
 {
     assert(!stack.empty() && !modulePos.empty());
     int64_t currModulePos = modulePos.back();
@@ -1031,6 +1416,7 @@ Var *VarStack::getAttr(StringRef name)
         res = stack[i]->getAttr(name);
         if(res || stack[i]->isFunc()) break;
     }
+    local = res != nullptr;
     if(!res) res = stack[currModulePos]->getAttr(name);
     return res;
 }
@@ -1045,7 +1431,7 @@ void VarStack::pushBlk(VirtualMachine &vm, ModuleLoc loc, size_t count)
 void VarStack::popBlk(VirtualMachine &vm, size_t count)
 {
     for(size_t i = 0; i < count; ++i) {
-        vm.decVarRef(stack.back());
+        vm.decFrameVarRef(stack.back());
         stack.pop_back();
     }
 }